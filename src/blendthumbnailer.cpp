@@ -0,0 +1,98 @@
+#include <QFile>
+#include <QtEndian>
+#include <QElapsedTimer>
+
+#include "blendthumbnailer.h"
+#include "imagescaler.h"
+
+#define BLEND_HEADER_SIZE 12
+// The preview is among the first blocks, give up after this many
+#define BLEND_MAX_BLOCKS 64
+#define BLEND_MAX_PREVIEW_SIZE 1024
+
+
+static qint32 blendInt(const char *p, bool bigEndian)
+{
+	const uchar *d = reinterpret_cast<const uchar*>(p);
+	return bigEndian ? qFromBigEndian<qint32>(d) : qFromLittleEndian<qint32>(d);
+}
+
+
+QStringList BlendThumbnailer::nameFilters() const
+{
+	return QStringList() << "*.blend";
+}
+
+QImage BlendThumbnailer::render(const QFileInfo &fi, int size, int budgetMs) const
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QFile f(fi.absoluteFilePath());
+	char header[BLEND_HEADER_SIZE];
+
+	if (!f.open(QIODevice::ReadOnly) || f.read(header, BLEND_HEADER_SIZE) != BLEND_HEADER_SIZE)
+		return QImage();
+
+	// "BLENDER", pointer size '_' (4) or '-' (8), endianness 'v' or 'V', version
+	if (qstrncmp(header, "BLENDER", 7) != 0 || (header[7] != '_' && header[7] != '-')
+			|| (header[8] != 'v' && header[8] != 'V'))
+		return QImage();
+
+	const bool bigEndian = header[8] == 'V';
+
+	// code, data size, old pointer, SDNA index, count
+	const int blockHeaderSize = header[7] == '-' ? 24 : 20;
+	qint64 pos = BLEND_HEADER_SIZE;
+
+	for (int i = 0; i < BLEND_MAX_BLOCKS; i++)
+	{
+		if (timer.elapsed() > budgetMs)
+			return QImage();
+
+		char block[24];
+
+		if (!f.seek(pos) || f.read(block, blockHeaderSize) != blockHeaderSize)
+			return QImage();
+
+		const qint32 dataSize = blendInt(block + 4, bigEndian);
+
+		if (qstrncmp(block, "ENDB", 4) == 0 || qstrncmp(block, "DATA", 4) == 0 || dataSize < 0)
+			return QImage();
+
+		if (qstrncmp(block, "TEST", 4) != 0)
+		{
+			pos += blockHeaderSize + dataSize;
+			continue;
+		}
+
+		// width, height and RGBA rows from the bottom up
+		char dims[8];
+
+		if (dataSize < 8 || f.read(dims, 8) != 8)
+			return QImage();
+
+		const qint32 w = blendInt(dims, bigEndian);
+		const qint32 h = blendInt(dims + 4, bigEndian);
+
+		if (w <= 0 || h <= 0 || w > BLEND_MAX_PREVIEW_SIZE || h > BLEND_MAX_PREVIEW_SIZE
+				|| qint64(w) * h * 4 + 8 > dataSize)
+			return QImage();
+
+		QImage img(w, h, QImage::Format_RGBA8888);
+		const int rowSize = w * 4;
+
+		for (int y = h - 1; y >= 0; y--)
+		{
+			if (f.read(reinterpret_cast<char*>(img.scanLine(y)), rowSize) != rowSize)
+				return QImage();
+		}
+
+		if (img.width() > size || img.height() > size)
+			return ImageScaler::scaledToFit(img, QSize(size, size));
+
+		return img;
+	}
+
+	return QImage();
+}
@@ -0,0 +1,21 @@
+#ifndef BLENDTHUMBNAILER_H
+#define BLENDTHUMBNAILER_H
+
+#include "thumbnailer.h"
+
+/*!
+ * \brief Previews embedded in Blender files
+ *
+ * Blender saves the preview as the TEST block near the beginning of the
+ * file. Block headers are walked with a seek over every block's data,
+ * so only the headers and the preview itself are read. Compressed files
+ * would have to be inflated up to the block and are skipped.
+ */
+class BlendThumbnailer : public AbstractThumbnailer
+{
+public:
+	QStringList nameFilters() const;
+	QImage render(const QFileInfo &fi, int size, int budgetMs) const;
+};
+
+#endif // BLENDTHUMBNAILER_H
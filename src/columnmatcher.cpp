@@ -0,0 +1,180 @@
+#include <QObject>
+
+#include "columnmatcher.h"
+
+
+ColumnMatcher::ColumnMatcher()
+	: m_mode(Substring)
+{
+}
+
+ColumnMatcher::ColumnMatcher(const QString &pattern, Mode mode)
+	: m_mode(mode),
+	  m_pattern(pattern),
+	  m_folded(fold(pattern))
+{
+	switch (m_mode)
+	{
+	case Substring:
+		m_matcher.setPattern(m_folded);
+		m_matcher.setCaseSensitivity(Qt::CaseSensitive);
+		break;
+
+	case Prefix:
+		break;
+
+	case Wildcard:
+	{
+		QString rx;
+
+		foreach (const QChar &c, m_folded)
+		{
+			if (c == '*')
+				rx += ".*";
+			else if (c == '?')
+				rx += '.';
+			else
+				rx += QRegularExpression::escape(QString(c));
+		}
+
+		m_rx.setPattern("\\A(?:" + rx + ")\\z");
+		m_rx.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
+		m_rx.optimize();
+		break;
+	}
+
+	case RegExp:
+		// Folding the pattern itself would break escapes like \D, so only
+		// the diacritics are stripped and case is left to the engine.
+		m_rx.setPattern("\\A(?:" + stripDiacritics(m_pattern) + ")\\z");
+		m_rx.setPatternOptions(QRegularExpression::CaseInsensitiveOption
+							   | QRegularExpression::UseUnicodePropertiesOption);
+		m_rx.optimize();
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool ColumnMatcher::isValid() const
+{
+	if (m_mode == Wildcard || m_mode == RegExp)
+		return m_rx.isValid();
+
+	return true;
+}
+
+bool ColumnMatcher::matches(const QChar *data, int length) const
+{
+	switch (m_mode)
+	{
+	case Substring:
+		return m_matcher.indexIn(data, length) != -1;
+
+	case Prefix:
+		return length >= m_folded.size()
+			   && QString::fromRawData(data, m_folded.size()) == m_folded;
+
+	case Wildcard:
+	case RegExp:
+		return m_rx.match(QString::fromRawData(data, length)).hasMatch();
+
+	default:
+		return true;
+	}
+}
+
+bool ColumnMatcher::matches(const QString &folded) const
+{
+	return matches(folded.constData(), folded.size());
+}
+
+QString ColumnMatcher::fold(const QString &str)
+{
+	const int len = str.size();
+	const QChar *data = str.constData();
+	bool ascii = true;
+
+	for (int i = 0; i < len; i++)
+	{
+		if (data[i].unicode() >= 0x80)
+		{
+			ascii = false;
+			break;
+		}
+	}
+
+	if (ascii)
+		return str.toLower();
+
+	return stripDiacritics(str).toCaseFolded();
+}
+
+QString ColumnMatcher::stripDiacritics(const QString &str)
+{
+	QString decomposed = str.normalized(QString::NormalizationForm_KD);
+	QString ret;
+	ret.reserve(decomposed.size());
+
+	foreach (const QChar &c, decomposed)
+	{
+		if (c.category() != QChar::Mark_NonSpacing)
+			ret.append(c);
+	}
+
+	return ret;
+}
+
+QString ColumnMatcher::modeLabel(Mode mode)
+{
+	switch (mode)
+	{
+	case Substring:
+		return QObject::tr("Contains");
+	case Prefix:
+		return QObject::tr("Starts with");
+	case Wildcard:
+		return QObject::tr("Wildcard");
+	case RegExp:
+		return QObject::tr("Regular expression");
+	default:
+		return QString();
+	}
+}
+
+
+void FoldedColumn::clear()
+{
+	m_buffer.clear();
+	m_offsets.clear();
+}
+
+void FoldedColumn::reserve(int rows, int chars)
+{
+	m_buffer.reserve(chars);
+	m_offsets.reserve(rows + 1);
+}
+
+void FoldedColumn::append(const QString &value)
+{
+	if (m_offsets.isEmpty())
+		m_offsets << 0;
+
+	m_buffer += ColumnMatcher::fold(value);
+	m_offsets << m_buffer.size();
+}
+
+int FoldedColumn::count() const
+{
+	return m_offsets.isEmpty() ? 0 : m_offsets.size() - 1;
+}
+
+bool FoldedColumn::matches(int row, const ColumnMatcher &matcher) const
+{
+	if (row < 0 || row >= count())
+		return false;
+
+	const int from = m_offsets[row];
+	return matcher.matches(m_buffer.constData() + from, m_offsets[row+1] - from);
+}
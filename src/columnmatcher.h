@@ -0,0 +1,79 @@
+#ifndef COLUMNMATCHER_H
+#define COLUMNMATCHER_H
+
+#include <QString>
+#include <QStringMatcher>
+#include <QRegularExpression>
+#include <QVector>
+
+/*!
+ * \brief Matches a filter pattern against folded column values
+ *
+ * Both the pattern and the values are folded by fold(), i.e. they are
+ * case folded and stripped of diacritics, so that "Šroub" matches "sroub".
+ * All the expensive work (pattern folding, matcher tables, regular
+ * expression compilation) is done once in the constructor.
+ */
+class ColumnMatcher
+{
+public:
+	enum Mode {
+		Substring = 0,
+		Prefix,
+		Wildcard,
+		RegExp,
+		ModeCount
+	};
+
+	ColumnMatcher();
+	ColumnMatcher(const QString &pattern, Mode mode);
+
+	Mode mode() const {
+		return m_mode;
+	}
+
+	QString pattern() const {
+		return m_pattern;
+	}
+
+	//! False for an invalid regular expression
+	bool isValid() const;
+
+	//! Match already folded value
+	bool matches(const QChar *data, int length) const;
+	bool matches(const QString &folded) const;
+
+	//! Case and diacritic insensitive normal form of \a str
+	static QString fold(const QString &str);
+	static QString modeLabel(Mode mode);
+
+private:
+	Mode m_mode;
+	QString m_pattern;
+	QString m_folded;
+	QStringMatcher m_matcher;
+	QRegularExpression m_rx;
+
+	static QString stripDiacritics(const QString &str);
+};
+
+/*!
+ * \brief Folded values of one column stored in a single contiguous buffer
+ *
+ * Values are indexed by FileModel row.
+ */
+class FoldedColumn
+{
+public:
+	void clear();
+	void reserve(int rows, int chars);
+	void append(const QString &value);
+	int count() const;
+	bool matches(int row, const ColumnMatcher &matcher) const;
+
+private:
+	QString m_buffer;
+	QVector<int> m_offsets;
+};
+
+#endif // COLUMNMATCHER_H
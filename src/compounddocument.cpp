@@ -0,0 +1,251 @@
+#include <QtEndian>
+
+#include "compounddocument.h"
+
+// Special sector numbers
+#define CFB_END_OF_CHAIN 0xfffffffe
+#define CFB_FREE_SECTOR 0xffffffff
+// Directory entry types
+#define CFB_STREAM 2
+#define CFB_ROOT 5
+// FAT sector numbers stored directly in the header
+#define CFB_HEADER_DIFAT 109
+
+
+static quint32 le32(const char *p)
+{
+	return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(p));
+}
+
+static quint16 le16(const char *p)
+{
+	return qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(p));
+}
+
+
+CompoundDocument::CompoundDocument(const QString &path)
+	: m_file(path),
+	  m_valid(false)
+{
+	static const char signature[] = "\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1";
+	char h[512];
+
+	if (!m_file.open(QIODevice::ReadOnly) || m_file.read(h, sizeof(h)) != sizeof(h))
+		return;
+
+	if (memcmp(h, signature, 8) != 0)
+		return;
+
+	m_sectorShift = le16(h + 0x1e);
+	m_miniSectorShift = le16(h + 0x20);
+
+	if ((m_sectorShift != 9 && m_sectorShift != 12) || m_miniSectorShift != 6)
+		return;
+
+	const quint32 dirStart = le32(h + 0x30);
+	m_miniCutoff = le32(h + 0x38);
+	m_firstMiniFat = le32(h + 0x3c);
+	m_difatStart = le32(h + 0x44);
+	m_difatCount = le32(h + 0x48);
+
+	const quint32 fatCount = le32(h + 0x2c);
+
+	for (quint32 i = 0; i < qMin<quint32>(fatCount, CFB_HEADER_DIFAT); i++)
+		m_difat << le32(h + 0x4c + i * 4);
+
+	m_valid = readDirectory(dirStart);
+}
+
+bool CompoundDocument::isValid() const
+{
+	return m_valid;
+}
+
+int CompoundDocument::find(const QString &name) const
+{
+	for (int i = 0; i < m_entries.count(); i++)
+	{
+		if (m_entries[i].type == CFB_STREAM && m_entries[i].name.compare(name, Qt::CaseInsensitive) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+QByteArray CompoundDocument::stream(int entry, qint64 maxSize)
+{
+	if (!m_valid || entry < 0 || entry >= m_entries.count())
+		return QByteArray();
+
+	const Entry &e = m_entries[entry];
+
+	if (qint64(e.size) > maxSize)
+		return QByteArray();
+
+	QByteArray ret(int(e.size), Qt::Uninitialized);
+
+	if (e.size >= m_miniCutoff)
+	{
+		const QVector<quint32> sectors = chain(e.start);
+		const quint32 size = sectorSize();
+		QByteArray sector(size, Qt::Uninitialized);
+
+		if (qint64(sectors.count()) * size < qint64(e.size))
+			return QByteArray();
+
+		for (int i = 0; i * size < e.size; i++)
+		{
+			if (!readSector(sectors[i], sector.data()))
+				return QByteArray();
+
+			memcpy(ret.data() + i * size, sector.constData(), qMin<quint64>(size, e.size - i * size));
+		}
+
+		return ret;
+	}
+
+	// small streams are in the mini stream, its FAT and sectors are read once
+	if (m_miniFat.isEmpty())
+	{
+		foreach (quint32 s, chain(m_firstMiniFat))
+		{
+			QByteArray sector(sectorSize(), Qt::Uninitialized);
+
+			if (!readSector(s, sector.data()))
+				return QByteArray();
+
+			for (quint32 i = 0; i < sectorSize(); i += 4)
+				m_miniFat << le32(sector.constData() + i);
+		}
+
+		m_miniStream = chain(m_entries[0].start);
+	}
+
+	const quint32 miniSize = 1 << m_miniSectorShift;
+	const quint32 perSector = sectorSize() / miniSize;
+	quint32 mini = e.start;
+	quint32 loaded = CFB_FREE_SECTOR;
+	QByteArray sector(sectorSize(), Qt::Uninitialized);
+
+	for (quint64 pos = 0; pos < e.size; pos += miniSize)
+	{
+		if (mini >= quint32(m_miniFat.count()) || mini / perSector >= quint32(m_miniStream.count()))
+			return QByteArray();
+
+		const quint32 s = m_miniStream[mini / perSector];
+
+		if (s != loaded && !readSector(s, sector.data()))
+			return QByteArray();
+
+		loaded = s;
+
+		memcpy(ret.data() + pos, sector.constData() + (mini % perSector) * miniSize,
+			   qMin<quint64>(miniSize, e.size - pos));
+
+		mini = m_miniFat[mini];
+	}
+
+	return ret;
+}
+
+quint32 CompoundDocument::sectorSize() const
+{
+	return 1 << m_sectorShift;
+}
+
+qint64 CompoundDocument::maxSectors() const
+{
+	return m_file.size() / sectorSize() + 1;
+}
+
+bool CompoundDocument::readSector(quint32 sector, char *data)
+{
+	const qint64 size = sectorSize();
+
+	return m_file.seek((qint64(sector) + 1) * size) && m_file.read(data, size) == size;
+}
+
+bool CompoundDocument::loadFatSector(int index)
+{
+	// the rest of the FAT sector numbers is in a chain of DIFAT sectors
+	while (index >= m_difat.count() && m_difatCount > 0 && m_difatStart < CFB_END_OF_CHAIN)
+	{
+		QByteArray sector(sectorSize(), Qt::Uninitialized);
+
+		if (!readSector(m_difatStart, sector.data()))
+			return false;
+
+		const int last = sectorSize() / 4 - 1;
+
+		for (int i = 0; i < last; i++)
+			m_difat << le32(sector.constData() + i * 4);
+
+		m_difatStart = le32(sector.constData() + last * 4);
+		m_difatCount--;
+	}
+
+	if (index >= m_difat.count())
+		return false;
+
+	QByteArray sector(sectorSize(), Qt::Uninitialized);
+
+	if (!readSector(m_difat[index], sector.data()))
+		return false;
+
+	m_fat.insert(index, sector);
+	return true;
+}
+
+quint32 CompoundDocument::nextSector(quint32 sector)
+{
+	const quint32 perSector = sectorSize() / 4;
+	const int index = sector / perSector;
+
+	if (!m_fat.contains(index) && !loadFatSector(index))
+		return CFB_END_OF_CHAIN;
+
+	return le32(m_fat[index].constData() + (sector % perSector) * 4);
+}
+
+QVector<quint32> CompoundDocument::chain(quint32 start)
+{
+	QVector<quint32> ret;
+	const qint64 limit = maxSectors();
+
+	// corrupted files may contain cycles
+	while (start < CFB_END_OF_CHAIN && ret.count() < limit)
+	{
+		ret << start;
+		start = nextSector(start);
+	}
+
+	return ret;
+}
+
+bool CompoundDocument::readDirectory(quint32 start)
+{
+	QByteArray sector(sectorSize(), Qt::Uninitialized);
+
+	foreach (quint32 s, chain(start))
+	{
+		if (!readSector(s, sector.data()))
+			return false;
+
+		for (quint32 off = 0; off < sectorSize(); off += 128)
+		{
+			const char *d = sector.constData() + off;
+			const int nameLength = qMin<int>(le16(d + 0x40), 64);
+
+			Entry e;
+			e.name = QString::fromUtf16(reinterpret_cast<const ushort*>(d), qMax(0, nameLength / 2 - 1));
+			e.type = d[0x42];
+			e.start = le32(d + 0x74);
+			// the high part is not reliable in version 3 files
+			e.size = m_sectorShift == 9 ? le32(d + 0x78) : qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(d + 0x78));
+
+			m_entries << e;
+		}
+	}
+
+	return !m_entries.isEmpty() && m_entries[0].type == CFB_ROOT;
+}
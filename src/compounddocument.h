@@ -0,0 +1,63 @@
+#ifndef COMPOUNDDOCUMENT_H
+#define COMPOUNDDOCUMENT_H
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+
+/*!
+ * \brief Read-only access to streams of an OLE2 compound document
+ *
+ * Used for files of SolidWorks, Inventor, Solid Edge or old MS Office.
+ * Only the header, the directory and the sectors of the requested
+ * streams are read. FAT sectors are read one by one when a chain passes
+ * through them, so reading a small stream from a large assembly costs
+ * just a few reads.
+ */
+class CompoundDocument
+{
+public:
+	explicit CompoundDocument(const QString &path);
+
+	bool isValid() const;
+	//! Directory entry of the stream named \a name (case insensitive), -1 if not found
+	int find(const QString &name) const;
+	//! Contents of the stream at directory \a entry, null if it's larger than \a maxSize
+	QByteArray stream(int entry, qint64 maxSize);
+
+private:
+	struct Entry {
+		QString name;
+		quint8 type;
+		quint32 start;
+		quint64 size;
+	};
+
+	QFile m_file;
+	bool m_valid;
+	int m_sectorShift;
+	int m_miniSectorShift;
+	quint32 m_miniCutoff;
+	quint32 m_firstMiniFat;
+	quint32 m_difatStart;
+	quint32 m_difatCount;
+	//! FAT sector numbers, the first 109 are in the header
+	QVector<quint32> m_difat;
+	//! FAT sectors read so far
+	QHash<quint32, QByteArray> m_fat;
+	QVector<quint32> m_miniFat;
+	//! sectors of the mini stream
+	QVector<quint32> m_miniStream;
+	QVector<Entry> m_entries;
+
+	quint32 sectorSize() const;
+	qint64 maxSectors() const;
+	bool readSector(quint32 sector, char *data);
+	quint32 nextSector(quint32 sector);
+	QVector<quint32> chain(quint32 start);
+	bool loadFatSector(int index);
+	bool readDirectory(quint32 start);
+};
+
+#endif // COMPOUNDDOCUMENT_H
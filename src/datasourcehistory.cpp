@@ -16,7 +16,7 @@ bool DataSourceHistory::canGoBack() const
 
 void DataSourceHistory::goBack()
 {
-	emit openDirectory(m_history[--m_currentIndex]);
+	emit restoreDirectory(m_history[--m_currentIndex]);
 	update();
 }
 
@@ -27,7 +27,7 @@ bool DataSourceHistory::canGoForward() const
 
 void DataSourceHistory::goForward()
 {
-	emit openDirectory(m_history[++m_currentIndex]);
+	emit restoreDirectory(m_history[++m_currentIndex]);
 	update();
 }
 
@@ -23,6 +23,8 @@ signals:
 	void canGoBackChanged(bool can);
 	void canGoForwardChanged(bool can);
 	void openDirectory(const QString &path);
+	//! Open a directory from history, its last view state can be restored
+	void restoreDirectory(const QString &path);
 
 private:
 	QStringList m_history;
@@ -22,6 +22,7 @@
 #include <QDir>
 #include <QDebug>
 #include "settings.h"
+#include "iconcache.h"
 
 DataSourceModel::DataSourceModel(QObject *parent) :
 	QFileSystemModel(parent)
@@ -97,39 +98,15 @@ QIcon DataSourceIconProvider::icon ( IconType type ) const
 
 QIcon DataSourceIconProvider::icon ( const QFileInfo & info ) const
 {
-	QString logoPath = info.absoluteFilePath() +"/"+ METADATA_DIR +"/";
-
 	if (!info.isDir())
-	{
-		return QFileIconProvider::icon(info);
-	}
-	else if (QFile::exists(logoPath + LOGO_FILE))
-	{
-		return QIcon(logoPath + LOGO_FILE);
-	}
-	else if (QFile::exists(logoPath + LOGO_TEXT_FILE))
-	{
-		return QIcon(logoPath + LOGO_TEXT_FILE);
-	}
-	else
 		return QFileIconProvider::icon(info);
+
+	return IconCache::get()->directoryIcon(info);
 }
 
 QPixmap DataSourceIconProvider::pixmap(const QFileInfo &info) const
 {
-	QString logoPath = info.absoluteFilePath() +"/"+ METADATA_DIR +"/";
-	if (QFile::exists(logoPath + LOGO_FILE))
-	{
-		return QPixmap(logoPath + LOGO_FILE);
-	}
-	else if (QFile::exists(logoPath + LOGO_TEXT_FILE))
-	{
-		return QPixmap(logoPath + LOGO_TEXT_FILE);
-	}
-	else
-	{
-		return QFileIconProvider::icon(info).pixmap(32, 32);
-	}
+	return IconCache::get()->directoryIcon(info);
 }
 
 QString DataSourceIconProvider::type ( const QFileInfo & info ) const
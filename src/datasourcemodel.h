@@ -64,7 +64,7 @@ public:
 	/*! \brief Handle custom logo files or standard file browser icons as QPixmaps.
 	 * The request is simple - to allow various sized pixmaps to be displayed.
 	 * Basically there is no image resizing allowed. Logo files are used as-is,
-	 * standard icons are resized to 32x32
+	 * standard icons are resized to 32x32. Pixmaps are cached in IconCache.
 	 */
 	QPixmap pixmap(const QFileInfo &info) const;
 };
@@ -0,0 +1,19 @@
+#ifndef DATASOURCEPATHS_H
+#define DATASOURCEPATHS_H
+
+// Files and directories within data source directories,
+// shared with the command line tools
+
+
+#define METADATA_DIR "0000-index"
+#define THUMBNAILS_DIR "0000-index/thumbnails"
+// Packed thumbnails, see ThumbnailPack
+#define THUMBNAILS_PACK "0000-index/thumbnails.pack"
+#define PROTOTYPE_DIR "0000-index/prototypes"
+// If presented - display only the logo
+#define LOGO_FILE "logo.png"
+// if presented - display logo and text
+#define LOGO_TEXT_FILE "logo-text.png"
+#define METADATA_FILE "metadata.ini"
+
+#endif // DATASOURCEPATHS_H
@@ -22,6 +22,8 @@ DataSourceWidget::DataSourceWidget(const QString &dir, QWidget *parent)
 
 	connect(m_history, SIGNAL(openDirectory(QString)),
 			this, SLOT(setDirectory(QString)));
+	connect(m_history, SIGNAL(restoreDirectory(QString)),
+			this, SLOT(restoreDirectory(QString)));
 
 	setupDataSources(dir);
 }
@@ -74,6 +76,16 @@ QModelIndex DataSourceWidget::currentIndex()
 }
 
 void DataSourceWidget::setDirectory(const QString &path)
+{
+	navigate(path, false);
+}
+
+void DataSourceWidget::restoreDirectory(const QString &path)
+{
+	navigate(path, true);
+}
+
+void DataSourceWidget::navigate(const QString &path, bool restore)
 {
 	for (int i = 0; i < dsList->count(); ++i)
 	{
@@ -81,7 +93,12 @@ void DataSourceWidget::setDirectory(const QString &path)
 		if (w->navigateToDirectory(path))
 		{
 			dsList->setCurrentIndex(i);
-			dirWidget->setDirectory(path);
+
+			if (restore)
+				dirWidget->restoreDirectory(path);
+			else
+				dirWidget->setDirectory(path);
+
 			m_currentDir = path;
 		}
 	}
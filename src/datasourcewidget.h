@@ -42,6 +42,7 @@ public slots:
 	void expand(const QModelIndex & index);
 	void settingsChanged();
 	void setDirectory(const QString &path);
+	void restoreDirectory(const QString &path);
 	void goToWorkingDirectory();
 
 private:
@@ -54,6 +55,7 @@ private slots:
 	void splitterMoved(int, int);
 	void handleOpenPartDirectory(const QFileInfo &fi);
 	void announceDirectoryChange(const QString &dir);
+	void navigate(const QString &path, bool restore);
 };
 
 #endif // DATASOURCEWIDGET_H
@@ -3,6 +3,7 @@
 #include "settings.h"
 #include "metadata.h"
 #include "partcache.h"
+#include "iconcache.h"
 #include "directorylocaleeditwidget.h"
 
 #include <QFileDialog>
@@ -88,6 +89,8 @@ void DirectoryEditorDialog::apply()
 		installIcon(iconInstallPath(LOGO_TEXT_FILE), LOGO_FILE, true);
 	}
 
+	IconCache::get()->invalidateLogo(m_dirPath);
+
 	// Subdirectory parts
 	MetadataCache::get()->metadata(m_dirPath)->setShowDirectoriesAsParts(
 		ui->subdirPartsCheckBox->isChecked()
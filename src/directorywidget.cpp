@@ -10,13 +10,18 @@
 #include "filemodel.h"
 #include "filefiltermodel.h"
 #include "settings.h"
+#include "partcache.h"
 #include "filtersdialog.h"
 #include "extensions/productview/productview.h"
 
+// Index file listings remembered for history restores, two per directory
+#define INDEX_FILES_CACHE 32
+
 
 DirectoryWidget::DirectoryWidget(QWidget *parent) :
 	QWidget(parent),
-	ui(new Ui::DirectoryWidget)
+	ui(new Ui::DirectoryWidget),
+	m_indexFiles(INDEX_FILES_CACHE)
 {
 	ui->setupUi(this);
 
@@ -86,6 +91,11 @@ DirectoryWidget::DirectoryWidget(QWidget *parent) :
 	connect(ui->filterButton, SIGNAL(clicked()),
 	        this, SLOT(setFiltersDialog()));
 
+	connect(PartCache::get(), SIGNAL(cleared(QString)),
+			this, SLOT(clearIndexFiles()));
+	connect(MetadataCache::get(), SIGNAL(cleared()),
+			this, SLOT(clearIndexFiles()));
+
 	ui->dirWebView->loadAboutPage();
 }
 
@@ -100,10 +110,17 @@ void DirectoryWidget::setDirectory(const QString &rootPath)
 
 	// set the directory to the file model
 	ui->partsTreeView->setDirectory(rootPath);
-	// handle the ui->partsWebView, custom index-parts*.html page in "parts" tab
-	loadIndexHtml(rootPath, ui->partsWebView, "index-parts", true);
-	// handle the ui->partsWebView, custom index*.html page in "parts" tab
-	loadIndexHtml(rootPath, ui->dirWebView, "index", false);
+	loadIndexPages(rootPath, false);
+
+	setEnabled(true);
+}
+
+void DirectoryWidget::restoreDirectory(const QString &rootPath)
+{
+	setEnabled(false);
+
+	ui->partsTreeView->restoreDirectory(rootPath);
+	loadIndexPages(rootPath, true);
 
 	setEnabled(true);
 }
@@ -114,7 +131,15 @@ void DirectoryWidget::updateDirectory(const QString &rootPath)
 		ui->partsTreeView->directoryChanged();
 }
 
-void DirectoryWidget::loadIndexHtml(const QString &rootPath, QWebEngineView *webView, const QString &filterBase, bool hideIfNotFound)
+void DirectoryWidget::loadIndexPages(const QString &rootPath, bool restore)
+{
+	// handle the ui->partsWebView, custom index-parts*.html page in "parts" tab
+	loadIndexHtml(rootPath, ui->partsWebView, "index-parts", true, restore);
+	// handle the ui->dirWebView, custom index*.html page in "tech specs" tab
+	loadIndexHtml(rootPath, ui->dirWebView, "index", false, restore);
+}
+
+void DirectoryWidget::loadIndexHtml(const QString &rootPath, QWebEngineView *webView, const QString &filterBase, bool hideIfNotFound, bool restore)
 {
 	QStringList filters;
 	filters << filterBase + "_??.html"
@@ -123,11 +148,22 @@ void DirectoryWidget::loadIndexHtml(const QString &rootPath, QWebEngineView *web
 	        << filterBase + ".htm";
 
 	QDir dir(rootPath + "/" + METADATA_DIR);
-	QStringList indexes = dir.entryList(filters, QDir::Files | QDir::Readable);
+	const QString key = filterBase + "/" + dir.path();
+	QStringList *cached = restore ? m_indexFiles.object(key) : 0;
+	QStringList indexes;
+
+	// only history restores use the listing of a recent visit
+	if (cached)
+	{
+		indexes = *cached;
+
+	} else {
+		indexes = dir.entryList(filters, QDir::Files | QDir::Readable);
+		m_indexFiles.insert(key, new QStringList(indexes));
+	}
 
 	if (indexes.isEmpty())
 	{
-		webView->setHtml("");
 		if (hideIfNotFound) webView->hide();
 		// load aboutPage only when there is no custom index.html and there is no WD specified
 		if (rootPath == DEFAULT_WDIR && webView == ui->dirWebView)
@@ -137,8 +173,13 @@ void DirectoryWidget::loadIndexHtml(const QString &rootPath, QWebEngineView *web
 		}
 		QDir d(rootPath);
 		if (!d.cdUp())
+		{
+			// the page is cleared only when no parent has an index,
+			// an inherited index is then not reloaded
+			webView->setHtml("");
 			return;
-		loadIndexHtml(d.absolutePath(), webView, filterBase, hideIfNotFound);
+		}
+		loadIndexHtml(d.absolutePath(), webView, filterBase, hideIfNotFound, restore);
 		return;
 	}
 
@@ -155,8 +196,19 @@ void DirectoryWidget::loadIndexHtml(const QString &rootPath, QWebEngineView *web
 		}
 	}
 
+	QUrl url = QUrl::fromLocalFile(dir.path() + "/" + selectedIndex);
+
 	webView->show();
-	webView->load(QUrl::fromLocalFile(dir.path() + "/" + selectedIndex));
+
+	// a restored page is not reloaded when it's still shown,
+	// siblings often share the index of their parent
+	if (!restore || webView->url() != url)
+		webView->load(url);
+}
+
+void DirectoryWidget::clearIndexFiles()
+{
+	m_indexFiles.clear();
 }
 
 void DirectoryWidget::editIndexFile(const QString &path)
@@ -252,6 +304,10 @@ void DirectoryWidget::dirWebViewEditButton_clicked()
 void DirectoryWidget::refreshButton_clicked()
 {
 	ui->partsTreeView->refreshRequested();
+
+	// the index pages may have been edited
+	if (!ui->partsTreeView->currentPath().isEmpty())
+		loadIndexPages(ui->partsTreeView->currentPath(), false);
 }
 
 void DirectoryWidget::dirWebView_urlChanged(const QUrl &url)
@@ -293,7 +349,7 @@ void DirectoryWidget::adjustThumbColumnWidth(int width)
 {
 	ui->partsTreeView->setColumnWidth(1, width);
 	Settings::get()->GUIThumbWidth = width;
-	ui->partsTreeView->settingsChanged();
+	ui->partsTreeView->thumbnailSizeChanged();
 }
 
 void DirectoryWidget::previewInProductView(const QFileInfo &fi)
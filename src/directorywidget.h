@@ -2,6 +2,7 @@
 #define DIRECTORYWIDGET_H
 
 #include <QWidget>
+#include <QCache>
 
 #include "datasourcemodel.h"
 
@@ -29,6 +30,8 @@ public:
 
 public slots:
 	void setDirectory(const QString &rootPath);
+	//! Set directory and restore its last view state, used by history
+	void restoreDirectory(const QString &rootPath);
 	void updateDirectory(const QString &rootPath);
 
 	void settingsChanged();
@@ -51,8 +54,12 @@ private:
 	Ui::DirectoryWidget *ui;
 
 	ProductView *m_productView;
+	//! metadata directory -> index files found in it on the last visit
+	QCache<QString, QStringList> m_indexFiles;
 
-	void loadIndexHtml(const QString &rootPath, QWebEngineView *webView, const QString &filterBase, bool hideIfNotFound);
+	//! Load index pages, \a restore reuses the listing and the page of a recent visit
+	void loadIndexPages(const QString &rootPath, bool restore);
+	void loadIndexHtml(const QString &rootPath, QWebEngineView *webView, const QString &filterBase, bool hideIfNotFound, bool restore);
 	void editIndexFile(const QString &path);
 
 private slots:
@@ -76,6 +83,7 @@ private slots:
 	void adjustThumbColumnWidth(int width);
 
 	void setFiltersDialog();
+	void clearIndexFiles();
 };
 
 #endif // DIRECTORYWIDGET_H
@@ -0,0 +1,527 @@
+#include <QFile>
+#include <QHash>
+#include <QPainter>
+#include <QPainterPath>
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <libdxfrw.h>
+#include <drw_interface.h>
+
+#include "dxfthumbnailer.h"
+
+// Entities smaller than this many pixels are not painted
+#define DXF_MIN_ENTITY_PIXELS 0.5
+// Nested inserts deeper than this are ignored, blocks may be recursive
+#define DXF_MAX_DEPTH 8
+// Line segments per full circle when flattening arcs
+#define DXF_ARC_SEGMENTS 48
+// Time budget is checked after this many painted entities
+#define DXF_CHECK_INTERVAL 1024
+// Empty space around the drawing, fraction of the size
+#define DXF_MARGIN 0.05
+// Larger files are not rendered, parsing cannot be interrupted by the budget
+#define DXF_MAX_FILE_SIZE (64 * 1024 * 1024)
+
+
+namespace {
+
+struct DxfItem {
+	QPainterPath path;
+	QRectF bounds;
+	bool fill;
+};
+
+struct DxfInsert {
+	QString block;
+	QPointF position;
+	double xScale;
+	double yScale;
+	double angle;
+};
+
+struct DxfBlock {
+	QPointF base;
+	QList<DxfItem> items;
+	QList<DxfInsert> inserts;
+	QRectF bounds;
+	bool boundsValid;
+
+	DxfBlock() : boundsValid(false) {}
+};
+
+/*!
+ * Collects model space geometry and blocks, everything else is ignored.
+ */
+class DxfCollector : public DRW_Interface
+{
+public:
+	DxfBlock model;
+	QHash<QString, DxfBlock> blocks;
+
+	DxfCollector() : m_current(&model) {}
+
+	void addHeader(const DRW_Header *) {}
+	void addLType(const DRW_LType &) {}
+	void addLayer(const DRW_Layer &) {}
+	void addDimStyle(const DRW_Dimstyle &) {}
+	void addVport(const DRW_Vport &) {}
+	void addTextStyle(const DRW_Textstyle &) {}
+	void addAppId(const DRW_AppId &) {}
+
+	void addBlock(const DRW_Block &data)
+	{
+		m_current = &blocks[QString::fromUtf8(data.name.c_str())];
+		m_current->base = QPointF(data.basePoint.x, data.basePoint.y);
+	}
+
+	void setBlock(const int) {}
+
+	void endBlock()
+	{
+		m_current = &model;
+	}
+
+	void addPoint(const DRW_Point &) {}
+
+	void addLine(const DRW_Line &data)
+	{
+		QPainterPath p(point(data.basePoint));
+		p.lineTo(point(data.secPoint));
+		add(data, p);
+	}
+
+	void addRay(const DRW_Ray &) {}
+	void addXline(const DRW_Xline &) {}
+
+	void addArc(const DRW_Arc &data)
+	{
+		double sweep = data.endangle - data.staangle;
+
+		if (sweep <= 0)
+			sweep += 2 * M_PI;
+
+		add(data, arc(point(data.basePoint), data.radious, data.staangle, sweep));
+	}
+
+	void addCircle(const DRW_Circle &data)
+	{
+		QPainterPath p;
+		p.addEllipse(point(data.basePoint), data.radious, data.radious);
+		add(data, p);
+	}
+
+	void addEllipse(const DRW_Ellipse &data)
+	{
+		const QPointF center = point(data.basePoint);
+		const QPointF major = point(data.secPoint);
+		const QPointF minor(-major.y() * data.ratio, major.x() * data.ratio);
+		double sweep = data.endparam - data.staparam;
+
+		if (sweep <= 0)
+			sweep += 2 * M_PI;
+
+		const int segments = segmentCount(sweep);
+		QPainterPath p;
+
+		for (int i = 0; i <= segments; i++)
+		{
+			const double t = data.staparam + sweep * i / segments;
+			const QPointF pt = center + major * std::cos(t) + minor * std::sin(t);
+
+			if (i == 0)
+				p.moveTo(pt);
+			else
+				p.lineTo(pt);
+		}
+
+		add(data, p);
+	}
+
+	void addLWPolyline(const DRW_LWPolyline &data)
+	{
+		QList<QPointF> points;
+		QList<double> bulges;
+
+		for (unsigned i = 0; i < data.vertlist.size(); i++)
+		{
+			points << QPointF(data.vertlist[i]->x, data.vertlist[i]->y);
+			bulges << data.vertlist[i]->bulge;
+		}
+
+		add(data, polyline(points, bulges, data.flags & 1));
+	}
+
+	void addPolyline(const DRW_Polyline &data)
+	{
+		QList<QPointF> points;
+		QList<double> bulges;
+
+		for (unsigned i = 0; i < data.vertlist.size(); i++)
+		{
+			points << point(data.vertlist[i]->basePoint);
+			bulges << data.vertlist[i]->bulge;
+		}
+
+		add(data, polyline(points, bulges, data.flags & 1));
+	}
+
+	void addSpline(const DRW_Spline *data)
+	{
+		// the control polygon is close enough at thumbnail sizes
+		const std::vector<DRW_Coord*> &pts = data->fitlist.empty() ? data->controllist : data->fitlist;
+		QList<QPointF> points;
+
+		for (unsigned i = 0; i < pts.size(); i++)
+			points << point(*pts[i]);
+
+		add(*data, polyline(points, QList<double>(), false));
+	}
+
+	void addKnot(const DRW_Entity &) {}
+
+	void addInsert(const DRW_Insert &data)
+	{
+		if (data.space != DRW::ModelSpace)
+			return;
+
+		DxfInsert ins;
+		ins.block = QString::fromUtf8(data.name.c_str());
+		ins.position = point(data.basePoint);
+		ins.xScale = data.xscale;
+		ins.yScale = data.yscale;
+		ins.angle = data.angle;
+
+		m_current->inserts << ins;
+	}
+
+	void addTrace(const DRW_Trace &data)
+	{
+		addFilled(data);
+	}
+
+	void add3dFace(const DRW_3Dface &data)
+	{
+		// corners are sequential and it's an outline, edges may be invisible
+		const QPointF corners[4] = {
+			point(data.basePoint), point(data.secPoint),
+			point(data.thirdPoint), point(data.fourPoint)
+		};
+		QPainterPath p(corners[0]);
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (data.invisibleflag & (1 << i))
+				p.moveTo(corners[(i + 1) % 4]);
+			else
+				p.lineTo(corners[(i + 1) % 4]);
+		}
+
+		add(data, p);
+	}
+
+	void addSolid(const DRW_Solid &data)
+	{
+		addFilled(data);
+	}
+
+	// illegible at thumbnail sizes
+	void addMText(const DRW_MText &) {}
+	void addText(const DRW_Text &) {}
+	void addDimAlign(const DRW_DimAligned *) {}
+	void addDimLinear(const DRW_DimLinear *) {}
+	void addDimRadial(const DRW_DimRadial *) {}
+	void addDimDiametric(const DRW_DimDiametric *) {}
+	void addDimAngular(const DRW_DimAngular *) {}
+	void addDimAngular3P(const DRW_DimAngular3p *) {}
+	void addDimOrdinate(const DRW_DimOrdinate *) {}
+	void addLeader(const DRW_Leader *) {}
+	void addHatch(const DRW_Hatch *) {}
+	void addViewport(const DRW_Viewport &) {}
+	void addImage(const DRW_Image *) {}
+	void linkImage(const DRW_ImageDef *) {}
+	void addComment(const char *) {}
+
+	// read only
+	void writeHeader(DRW_Header &) {}
+	void writeBlocks() {}
+	void writeBlockRecords() {}
+	void writeEntities() {}
+	void writeLTypes() {}
+	void writeLayers() {}
+	void writeTextstyles() {}
+	void writeVports() {}
+	void writeDimstyles() {}
+	void writeAppId() {}
+
+private:
+	DxfBlock *m_current;
+
+	static QPointF point(const DRW_Coord &c)
+	{
+		return QPointF(c.x, c.y);
+	}
+
+	static int segmentCount(double sweep)
+	{
+		return qMax(4, int(std::ceil(std::fabs(sweep) / (2 * M_PI) * DXF_ARC_SEGMENTS)));
+	}
+
+	static QPainterPath arc(const QPointF &center, double radius, double start, double sweep)
+	{
+		const int segments = segmentCount(sweep);
+		QPainterPath p;
+
+		for (int i = 0; i <= segments; i++)
+		{
+			const double a = start + sweep * i / segments;
+			const QPointF pt = center + QPointF(std::cos(a), std::sin(a)) * radius;
+
+			if (i == 0)
+				p.moveTo(pt);
+			else
+				p.lineTo(pt);
+		}
+
+		return p;
+	}
+
+	//! Segment from \a from to \a to, an arc when \a bulge is not zero
+	static void bulgeTo(QPainterPath &p, const QPointF &from, const QPointF &to, double bulge)
+	{
+		const QPointF d = to - from;
+		const double len = std::sqrt(d.x() * d.x() + d.y() * d.y());
+
+		if (std::fabs(bulge) < 1e-9 || len == 0)
+		{
+			p.lineTo(to);
+			return;
+		}
+
+		// the bulge is the tangent of a quarter of the included angle
+		const double sweep = 4 * std::atan(bulge);
+		const double h = len / 2 / std::tan(sweep / 2);
+		const QPointF normal(-d.y() / len, d.x() / len);
+		const QPointF center = (from + to) / 2 + normal * h;
+		const QPointF r = from - center;
+		const double radius = std::sqrt(r.x() * r.x() + r.y() * r.y());
+		const double start = std::atan2(r.y(), r.x());
+		const int segments = segmentCount(sweep);
+
+		for (int i = 1; i <= segments; i++)
+		{
+			const double a = start + sweep * i / segments;
+			p.lineTo(center + QPointF(std::cos(a), std::sin(a)) * radius);
+		}
+	}
+
+	static QPainterPath polyline(const QList<QPointF> &points, const QList<double> &bulges, bool closed)
+	{
+		QPainterPath p;
+
+		if (points.isEmpty())
+			return p;
+
+		p.moveTo(points.first());
+
+		const int cnt = closed ? points.count() : points.count() - 1;
+
+		for (int i = 0; i < cnt; i++)
+		{
+			const QPointF &to = points[(i + 1) % points.count()];
+			bulgeTo(p, points[i], to, i < bulges.count() ? bulges[i] : 0);
+		}
+
+		return p;
+	}
+
+	template <class T>
+	void addFilled(const T &data)
+	{
+		QPainterPath p(point(data.basePoint));
+		p.lineTo(point(data.secPoint));
+		// SOLID and TRACE corners are stored in Z order
+		p.lineTo(point(data.fourPoint));
+		p.lineTo(point(data.thirdPoint));
+		p.closeSubpath();
+
+		add(data, p, true);
+	}
+
+	void add(const DRW_Entity &entity, const QPainterPath &path, bool fill = false)
+	{
+		if (entity.space != DRW::ModelSpace || path.isEmpty())
+			return;
+
+		DxfItem item;
+		item.path = path;
+		item.bounds = path.boundingRect();
+		item.fill = fill;
+
+		m_current->items << item;
+	}
+};
+
+/*!
+ * Paints the model space, whole blocks are culled by their bounds.
+ */
+class DxfPainter
+{
+public:
+	DxfPainter(DxfCollector *dxf, QPainter *painter, const QElapsedTimer &timer, int budgetMs)
+		: m_dxf(dxf),
+		  m_painter(painter),
+		  m_timer(timer),
+		  m_budget(budgetMs),
+		  m_painted(0)
+	{
+	}
+
+	QRectF bounds(DxfBlock *block, int depth = 0)
+	{
+		if (block->boundsValid || depth > DXF_MAX_DEPTH)
+			return block->bounds;
+
+		QRectF r;
+
+		foreach (const DxfItem &item, block->items)
+			r |= item.bounds;
+
+		foreach (const DxfInsert &ins, block->inserts)
+		{
+			DxfBlock *child = find(ins.block);
+
+			if (child)
+				r |= transform(ins, child).mapRect(bounds(child, depth + 1));
+		}
+
+		block->bounds = r;
+		block->boundsValid = true;
+
+		return r;
+	}
+
+	//! False when the time budget ran out
+	bool paint(DxfBlock *block, const QTransform &t, int depth = 0)
+	{
+		if (depth > DXF_MAX_DEPTH)
+			return true;
+
+		foreach (const DxfItem &item, block->items)
+		{
+			if (++m_painted % DXF_CHECK_INTERVAL == 0 && m_timer.elapsed() > m_budget)
+				return false;
+
+			if (isTiny(t.mapRect(item.bounds)))
+				continue;
+
+			m_painter->setTransform(t);
+
+			if (item.fill)
+				m_painter->fillPath(item.path, m_painter->pen().color());
+			else
+				m_painter->drawPath(item.path);
+		}
+
+		foreach (const DxfInsert &ins, block->inserts)
+		{
+			DxfBlock *child = find(ins.block);
+
+			if (!child)
+				continue;
+
+			QTransform childT = transform(ins, child) * t;
+
+			if (isTiny(childT.mapRect(bounds(child))))
+				continue;
+
+			if (!paint(child, childT, depth + 1))
+				return false;
+		}
+
+		return true;
+	}
+
+private:
+	DxfCollector *m_dxf;
+	QPainter *m_painter;
+	const QElapsedTimer &m_timer;
+	int m_budget;
+	int m_painted;
+
+	DxfBlock *find(const QString &name)
+	{
+		QHash<QString, DxfBlock>::iterator it = m_dxf->blocks.find(name);
+		return it == m_dxf->blocks.end() ? 0 : &it.value();
+	}
+
+	static QTransform transform(const DxfInsert &ins, const DxfBlock *block)
+	{
+		return QTransform()
+				.translate(ins.position.x(), ins.position.y())
+				.rotateRadians(ins.angle)
+				.scale(ins.xScale, ins.yScale)
+				.translate(-block->base.x(), -block->base.y());
+	}
+
+	static bool isTiny(const QRectF &r)
+	{
+		return qMax(r.width(), r.height()) < DXF_MIN_ENTITY_PIXELS;
+	}
+};
+
+} // namespace
+
+
+QStringList DxfThumbnailer::nameFilters() const
+{
+	return QStringList() << "*.dxf";
+}
+
+QImage DxfThumbnailer::render(const QFileInfo &fi, int size, int budgetMs) const
+{
+	if (fi.size() > DXF_MAX_FILE_SIZE)
+		return QImage();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	DxfCollector dxf;
+	dxfRW reader(QFile::encodeName(fi.absoluteFilePath()).constData());
+
+	if (!reader.read(&dxf, false) || timer.elapsed() > budgetMs)
+		return QImage();
+
+	QImage img(size, size, QImage::Format_ARGB32_Premultiplied);
+	img.fill(Qt::transparent);
+
+	QPainter painter(&img);
+	DxfPainter dxfPainter(&dxf, &painter, timer, budgetMs);
+	const QRectF bounds = dxfPainter.bounds(&dxf.model);
+
+	if (bounds.isNull())
+		return QImage();
+
+	const double extent = qMax(bounds.width(), bounds.height());
+	const double scale = extent > 0 ? size * (1 - 2 * DXF_MARGIN) / extent : 1;
+
+	// Y goes up in DXF
+	QTransform view = QTransform()
+			.translate(size / 2.0, size / 2.0)
+			.scale(scale, -scale)
+			.translate(-bounds.center().x(), -bounds.center().y());
+
+	QPen pen(Qt::black, 0);
+	pen.setCosmetic(true);
+
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setPen(pen);
+	painter.setBrush(Qt::NoBrush);
+
+	if (!dxfPainter.paint(&dxf.model, view))
+		return QImage();
+
+	painter.end();
+
+	return img;
+}
@@ -0,0 +1,25 @@
+#ifndef DXFTHUMBNAILER_H
+#define DXFTHUMBNAILER_H
+
+#include "thumbnailer.h"
+
+/*!
+ * \brief DXF drawings parsed by libdxfrw and painted into a QImage
+ *
+ * Unlike DxfProductView it does not build a QGraphicsScene, entities are
+ * collected as painter paths and painted by QPainter on a QImage, which
+ * is safe outside of the GUI thread. Text, dimensions and hatches are
+ * left out and entities smaller than a pixel are culled, they would
+ * only blur the thumbnail.
+ *
+ * Only painting is bounded by the time budget, libdxfrw parses the whole
+ * file at once. Files over DXF_MAX_FILE_SIZE are therefore skipped.
+ */
+class DxfThumbnailer : public AbstractThumbnailer
+{
+public:
+	QStringList nameFilters() const;
+	QImage render(const QFileInfo &fi, int size, int budgetMs) const;
+};
+
+#endif // DXFTHUMBNAILER_H
@@ -2,6 +2,9 @@
 #include "ui_imageproductview.h"
 
 #include <QPixmap>
+#include <QImageReader>
+
+#include "imagescaler.h"
 
 
 ImageProductView::ImageProductView(QWidget *parent) :
@@ -28,10 +31,13 @@ FileTypeList ImageProductView::canHandle()
 
 bool ImageProductView::handle(FileMetadata *f)
 {
-    QPixmap p(f->fileInfo.absoluteFilePath());
-    if (!p.isNull())
+    QImageReader reader(f->fileInfo.absoluteFilePath());
+    reader.setAutoTransform(true);
+    m_image = reader.read();
+
+    if (!m_image.isNull())
     {
-        ui->label->setPixmap(p);
+        updatePixmap();
         return true;
     }
     else
@@ -43,3 +49,21 @@ bool ImageProductView::handle(FileMetadata *f)
         return false;
     }
 }
+
+void ImageProductView::resizeEvent(QResizeEvent *event)
+{
+    AbstractProductView::resizeEvent(event);
+
+    if (!m_image.isNull())
+        updatePixmap();
+}
+
+void ImageProductView::updatePixmap()
+{
+    QSize available = ui->scrollArea->viewport()->size();
+
+    if (m_image.width() <= available.width() && m_image.height() <= available.height())
+        ui->label->setPixmap(QPixmap::fromImage(m_image));
+    else
+        ui->label->setPixmap(QPixmap::fromImage(ImageScaler::scaledToFit(m_image, available)));
+}
@@ -1,6 +1,8 @@
 #ifndef IMAGEPRODUCTVIEW_H
 #define IMAGEPRODUCTVIEW_H
 
+#include <QImage>
+
 #include "abstractproductview.h"
 
 namespace Ui {
@@ -19,8 +21,15 @@ public:
     FileTypeList canHandle();
     bool handle(FileMetadata *f);
 
+protected:
+    void resizeEvent(QResizeEvent *event);
+
 private:
     Ui::ImageProductView *ui;
+    QImage m_image;
+
+    //! Show the image downscaled to fit the view
+    void updatePixmap();
 };
 
 #endif // IMAGEPRODUCTVIEW_H
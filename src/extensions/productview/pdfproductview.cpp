@@ -1,22 +1,87 @@
 #ifdef HAVE_POPPLER
+#include <QThreadPool>
+#include <QTimer>
+#include <QScrollBar>
+#include <QScopedPointer>
+
+#include <poppler-qt5/poppler-qt5.h>
+
 #include "pdfproductview.h"
 #include "ui_pdfproductview.h"
 
-#if QT_VERSION < 0x050000
-#include <poppler/qt4/poppler-qt4.h>
-#else
-#include <poppler-qt5/poppler-qt5.h>
-#endif
+// Memory used by rendered pages, in kB
+#define PDF_PAGE_CACHE_SIZE (64 * 1024)
+// Pages are rendered again this long after the last resize
+#define PDF_RESIZE_DELAY 150
+#define PDF_MIN_PAGE_WIDTH 64
+
+
+PDFPageJob::PDFPageJob(QObject *view, QSharedPointer<Poppler::Document> document, int generation, int page, int width, qreal ratio)
+	: m_view(view),
+	  m_document(document),
+	  m_generation(generation),
+	  m_page(page),
+	  m_width(width),
+	  m_ratio(ratio)
+{
+}
+
+void PDFPageJob::run()
+{
+	QImage img;
+	QScopedPointer<Poppler::Page> page(m_document->page(m_page));
+
+	if (page)
+	{
+		// page size is in points, 72 per inch
+		const QSizeF points = page->pageSizeF();
+
+		if (points.width() > 0)
+		{
+			const qreal dpi = m_width * m_ratio * 72.0 / points.width();
+
+			img = page->renderToImage(dpi, dpi);
+			img.setDevicePixelRatio(m_ratio);
+		}
+	}
+
+	QMetaObject::invokeMethod(m_view, "pageRendered", Qt::QueuedConnection,
+							  Q_ARG(int, m_generation),
+							  Q_ARG(int, m_page),
+							  Q_ARG(int, m_width),
+							  Q_ARG(QImage, img));
+}
+
 
 PDFProductView::PDFProductView(QWidget *parent) :
 	AbstractProductView(parent),
-	ui(new Ui::PDFProductView)
+	ui(new Ui::PDFProductView),
+	m_generation(0),
+	m_page(0),
+	m_pageCount(0)
 {
 	ui->setupUi(this);
+
+	m_pool = new QThreadPool(this);
+	m_pool->setMaxThreadCount(1);
+
+	m_pages.setMaxCost(PDF_PAGE_CACHE_SIZE);
+
+	m_resizeTimer = new QTimer(this);
+	m_resizeTimer->setSingleShot(true);
+	m_resizeTimer->setInterval(PDF_RESIZE_DELAY);
+
+	connect(m_resizeTimer, SIGNAL(timeout()), this, SLOT(updatePage()));
+	connect(ui->pageSpinBox, SIGNAL(valueChanged(int)), this, SLOT(pageNumberChanged(int)));
+	connect(ui->previousButton, SIGNAL(clicked()), this, SLOT(previousPage()));
+	connect(ui->nextButton, SIGNAL(clicked()), this, SLOT(nextPage()));
 }
 
 PDFProductView::~PDFProductView()
 {
+	m_pool->clear();
+	m_pool->waitForDone();
+
 	delete ui;
 }
 
@@ -25,42 +90,153 @@ QString PDFProductView::title()
 	return tr("PDF Document");
 }
 
-QList<File::FileTypes> PDFProductView::canHandle()
+FileTypeList PDFProductView::canHandle()
 {
-	return QList<File::FileTypes>() << File::PDF;
+	return FileTypeList() << FileType::PDF;
 }
 
-bool PDFProductView::handle(File *f)
+bool PDFProductView::handle(FileMetadata *f)
 {
-	Poppler::Document* document = Poppler::Document::load(f->path);
-	if (!document || document->isLocked())
+	m_pool->clear();
+	m_generation++;
+	m_pages.clear();
+	m_pending.clear();
+	m_document.clear();
+	m_pageCount = 0;
+
+	const QString path = f->fileInfo.absoluteFilePath();
+	Poppler::Document *document = Poppler::Document::load(path);
+
+	if (!document || document->isLocked() || document->numPages() < 1)
 	{
-		ui->imageLabel->setText(tr("Unable to load: %1").arg(f->path));
 		delete document;
-		return false;
-	}
 
-	int pageNumber = 0;
-	Poppler::Page* pdfPage = document->page(pageNumber);  // Document starts at page 0
-	if (pdfPage == 0) {
-		ui->imageLabel->setText(tr("Unable to load page %1 from %2").arg(pageNumber).arg(f->path));
-		delete document;
+		ui->pageSpinBox->setEnabled(false);
+		ui->previousButton->setEnabled(false);
+		ui->nextButton->setEnabled(false);
+		ui->pageCountLabel->clear();
+		ui->imageLabel->setText(tr("Unable to load: %1").arg(path));
 		return false;
 	}
 
-	QImage image = pdfPage->renderToImage();
-	if (image.isNull()) {
-		ui->imageLabel->setText(tr("Unable to load page %1 from %2").arg(pageNumber).arg(f->path));
-		delete document;
-		return false;
-	}
+	// queried before the document is shared with m_pool
+	m_pageCount = document->numPages();
 
-	ui->imageLabel->setPixmap(QPixmap::fromImage(image));
+	document->setRenderHint(Poppler::Document::Antialiasing);
+	document->setRenderHint(Poppler::Document::TextAntialiasing);
+	m_document = QSharedPointer<Poppler::Document>(document);
 
-	delete pdfPage;
-	delete document;
+	ui->pageSpinBox->blockSignals(true);
+	ui->pageSpinBox->setRange(1, m_pageCount);
+	ui->pageSpinBox->blockSignals(false);
+	ui->pageSpinBox->setEnabled(true);
+	ui->pageCountLabel->setText(tr("of %1").arg(m_pageCount));
+	ui->imageLabel->clear();
 
+	setPage(0);
 	return true;
 }
 
+void PDFProductView::resizeEvent(QResizeEvent *event)
+{
+	AbstractProductView::resizeEvent(event);
+
+	if (m_document)
+		m_resizeTimer->start();
+}
+
+void PDFProductView::pageRendered(int generation, int page, int width, const QImage &image)
+{
+	if (generation != m_generation)
+		return;
+
+	m_pending.remove(pageKey(page, width));
+
+	if (image.isNull())
+	{
+		if (page == m_page)
+			ui->imageLabel->setText(tr("Unable to render page %1").arg(page + 1));
+
+		return;
+	}
+
+	m_pages.insert(pageKey(page, width), new QImage(image), image.bytesPerLine() * image.height() / 1024);
+
+	if (page == m_page && width == pageWidth())
+		ui->imageLabel->setPixmap(QPixmap::fromImage(image));
+}
+
+void PDFProductView::pageNumberChanged(int number)
+{
+	setPage(number - 1);
+}
+
+void PDFProductView::previousPage()
+{
+	setPage(m_page - 1);
+}
+
+void PDFProductView::nextPage()
+{
+	setPage(m_page + 1);
+}
+
+void PDFProductView::updatePage()
+{
+	setPage(m_page);
+}
+
+int PDFProductView::pageWidth() const
+{
+	// leave space for the vertical scroll bar, pages are usually taller than the view
+	const int width = ui->scrollArea->viewport()->width()
+			- (ui->scrollArea->verticalScrollBar()->isVisible() ? 0 : ui->scrollArea->verticalScrollBar()->sizeHint().width());
+
+	return qMax(width, PDF_MIN_PAGE_WIDTH);
+}
+
+QString PDFProductView::pageKey(int page, int width) const
+{
+	return QString("%1|%2").arg(page).arg(width);
+}
+
+void PDFProductView::setPage(int page)
+{
+	if (!m_document)
+		return;
+
+	m_page = qBound(0, page, m_pageCount - 1);
+
+	ui->pageSpinBox->blockSignals(true);
+	ui->pageSpinBox->setValue(m_page + 1);
+	ui->pageSpinBox->blockSignals(false);
+	ui->previousButton->setEnabled(m_page > 0);
+	ui->nextButton->setEnabled(m_page < m_pageCount - 1);
+
+	QImage *cached = m_pages.object(pageKey(m_page, pageWidth()));
+
+	if (cached)
+		ui->imageLabel->setPixmap(QPixmap::fromImage(*cached));
+	else
+		render(m_page, 1);
+
+	// the next page is likely to be viewed too
+	render(m_page + 1, 0);
+}
+
+void PDFProductView::render(int page, int priority)
+{
+	if (page >= m_pageCount)
+		return;
+
+	const int width = pageWidth();
+	const QString key = pageKey(page, width);
+
+	if (m_pages.contains(key) || m_pending.contains(key))
+		return;
+
+	m_pending << key;
+	m_pool->start(new PDFPageJob(this, m_document, m_generation, page, width, devicePixelRatioF()), priority);
+}
+
 #endif
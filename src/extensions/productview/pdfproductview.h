@@ -3,6 +3,11 @@
 #define PDFPRODUCTVIEW_H
 
 #include <QWidget>
+#include <QImage>
+#include <QCache>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QSet>
 
 #include "abstractproductview.h"
 
@@ -10,9 +15,42 @@ namespace Ui {
 class PDFProductView;
 }
 
+namespace Poppler {
+class Document;
+}
+
+class QThreadPool;
+class QTimer;
+
+
+/**
+ * @brief Renders one page of a PDF document in the background
+ *
+ * The result is delivered to PDFProductView::pageRendered() by a queued call.
+ */
+class PDFPageJob : public QRunnable
+{
+public:
+	PDFPageJob(QObject *view, QSharedPointer<Poppler::Document> document, int generation, int page, int width, qreal ratio);
+	void run();
+
+private:
+	QObject *m_view;
+	QSharedPointer<Poppler::Document> m_document;
+	int m_generation;
+	int m_page;
+	int m_width;
+	qreal m_ratio;
+};
+
 
 /**
  * @brief The PDFProductView class is a product view for PDF files
+ *
+ * Pages are rendered on demand at the width of the view, the next page
+ * is rendered in advance. Rendered pages are kept in an LRU cache, so
+ * paging back and forth does not render them again.
+ *
  * @see AbstractProductView
  */
 class PDFProductView : public AbstractProductView
@@ -24,11 +62,39 @@ public:
 	~PDFProductView();
 
 	QString title();
-	QList<File::FileTypes> canHandle();
+	FileTypeList canHandle();
 	bool handle(FileMetadata *f);
 
+protected:
+	void resizeEvent(QResizeEvent *event);
+
+private slots:
+	void pageRendered(int generation, int page, int width, const QImage &image);
+	void pageNumberChanged(int number);
+	void previousPage();
+	void nextPage();
+	//! Render the current page again at the new width
+	void updatePage();
+
 private:
 	Ui::PDFProductView *ui;
+	QThreadPool *m_pool;
+	//! Poppler documents must not be used from more threads at once, m_pool has one thread
+	QSharedPointer<Poppler::Document> m_document;
+	//! Increased with every document, results of older jobs are dropped
+	int m_generation;
+	int m_page;
+	//! Page count of m_document, read once so the GUI thread does not touch it
+	int m_pageCount;
+	//! Rendered pages, key is "page|width"
+	QCache<QString, QImage> m_pages;
+	QSet<QString> m_pending;
+	QTimer *m_resizeTimer;
+
+	int pageWidth() const;
+	QString pageKey(int page, int width) const;
+	void setPage(int page);
+	void render(int page, int priority);
 };
 
 #endif // PDFPRODUCTVIEW_H
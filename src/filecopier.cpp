@@ -1,4 +1,5 @@
 #include "filecopier.h"
+#include "filecopyengine.h"
 #include "progressdialog.h"
 
 #include <QDir>
@@ -6,6 +7,15 @@
 #include <QProgressBar>
 #include <QLabel>
 #include <QMessageBox>
+#include <QThreadPool>
+
+// Files larger than this are copied one at a time, smaller ones in parallel
+#define FILE_COPY_LARGE_FILE (8 * 1024 * 1024)
+#define FILE_COPY_THREADS 4
+// Progress counts every file as this many bytes on top of its size
+#define FILE_COPY_FILE_COST (64 * 1024)
+// Progress and throughput are reported at this interval
+#define FILE_COPY_REPORT_MSECS 200
 
 FileCopier::FileCopier(QWidget *parent)
 	: FileCopier(QFileInfoList(), QString(), parent)
@@ -71,10 +81,11 @@ void FileCopier::work()
 	m_cp->setSourceFiles(m_sourceFiles, m_dst);
 	m_cp->setStopOnError(m_stopOnError);
 
+	if (m_msg.isNull())
+		m_msg = tr("Please wait while the files are being copied...");
+
 	m_progress = new ProgressDialog(static_cast<QWidget*>(parent()));
-	m_progress->label()->setText(
-		m_msg.isNull() ? tr("Please wait while the files are being copied...") : m_msg
-	);
+	m_progress->label()->setText(m_msg);
 
 	// Quit after worker finishes
 	connect(m_cp, SIGNAL(finished()),
@@ -83,6 +94,8 @@ void FileCopier::work()
 	// Monitor progress
 	connect(m_cp, SIGNAL(progress(int,int)),
 			this, SLOT(progressUpdate(int,int)));
+	connect(m_cp, SIGNAL(statusChanged(QString)),
+			this, SLOT(statusUpdate(QString)));
 	connect(m_cp, SIGNAL(errorOccured(QString)),
 			this, SLOT(directoryDeletionError(QString)));
 	connect(m_cp, SIGNAL(fileExists(QFileInfo,QString)),
@@ -104,6 +117,11 @@ void FileCopier::progressUpdate(int done, int total)
 	m_progress->progressBar()->setValue(done);
 }
 
+void FileCopier::statusUpdate(const QString &status)
+{
+	m_progress->label()->setText(m_msg + "\n" + status);
+}
+
 void FileCopier::directoryDeletionError(const QString &error)
 {
 	QMessageBox::warning(
@@ -128,33 +146,77 @@ void FileCopier::confirmOverwrite(const QFileInfo &src, const QString &dst)
 			| QMessageBox::Cancel
 	);
 
+	FileCopierWorker::Overwrite overwrite;
+
 	switch (ret)
 	{
 	case QMessageBox::Yes:
-		m_cp->continueWork(FileCopierWorker::ONCE);
+		overwrite = FileCopierWorker::ONCE;
 		break;
 	case QMessageBox::No:
-		m_cp->continueWork(FileCopierWorker::NO);
+		overwrite = FileCopierWorker::NO;
 		break;
 	case QMessageBox::NoAll:
-		m_cp->continueWork(FileCopierWorker::NO_ALL);
+		overwrite = FileCopierWorker::NO_ALL;
 		break;
 	case QMessageBox::YesAll:
-		m_cp->continueWork(FileCopierWorker::YES_ALL);
+		overwrite = FileCopierWorker::YES_ALL;
 		break;
 	case QMessageBox::Cancel:
-		m_progress->reject();
-		break;
 	default:
-		break;
+		m_progress->reject();
+		return;
 	}
+
+	// continue in the worker's thread, not in the GUI one
+	QMetaObject::invokeMethod(m_cp, "continueWork", Qt::QueuedConnection,
+							  Q_ARG(FileCopierWorker::Overwrite, overwrite));
+}
+
+
+FileCopyJob::FileCopyJob(const QString &src, const QString &dst, QSharedPointer<FileCopyStats> stats)
+	: m_src(src),
+	  m_dst(dst),
+	  m_stats(stats)
+{
+}
+
+void FileCopyJob::run()
+{
+	qint64 copied;
+	QString error;
+
+	if (FileCopyEngine::copy(m_src, m_dst, &copied, &error))
+	{
+		m_stats->bytes.fetchAndAddRelaxed(copied);
+		m_stats->files.fetchAndAddRelaxed(1);
+		return;
+	}
+
+	m_stats->failed.fetchAndAddRelaxed(1);
+
+	QMutexLocker locker(&m_stats->mutex);
+	m_stats->errors << FileCopierWorker::tr("Unable to copy '%1': %2").arg(m_src).arg(error);
 }
 
 
 FileCopierWorker::FileCopierWorker(QObject *parent)
-	: ThreadWorker(parent)
+	: ThreadWorker(parent),
+	  m_next(0),
+	  m_totalBytes(0),
+	  m_skipped(0),
+	  m_skippedBytes(0),
+	  m_stopOnError(true),
+	  m_stats(new FileCopyStats),
+	  m_lastProgress(-1)
 {
+	qRegisterMetaType<FileCopierWorker::Overwrite>("FileCopierWorker::Overwrite");
 
+	m_smallPool = new QThreadPool(this);
+	m_smallPool->setMaxThreadCount(FILE_COPY_THREADS);
+
+	m_largePool = new QThreadPool(this);
+	m_largePool->setMaxThreadCount(1);
 }
 
 void FileCopierWorker::setSourceFiles(const QList<QPair<QFileInfo,QString>> &sourceFiles, const QString &dst)
@@ -175,113 +237,123 @@ void FileCopierWorker::run()
 	foreach (pair, m_sourceFiles)
 		recurse(pair.first, m_dst, pair.second);
 
+	if (!createDirectories())
+	{
+		quit();
+		return;
+	}
+
+	m_timer.start();
+	m_reportTimer.start();
+
 	continueWork();
 }
 
 void FileCopierWorker::continueWork(FileCopierWorker::Overwrite overwrite)
 {
-	int i = 0, done = 0, lastDone = 0;
-
-	qDebug() << "Going to copy" << m_files.count() << "files";
-
-	while (!m_files.isEmpty())
+	while (m_next < m_files.count())
 	{
-		QPair<QFileInfo, QString> pair = m_files.first();
-		QFileInfo src = pair.first;
-		QString dst = pair.second;
-		QDir d;
-		QFile file;
-		bool ret;
-
-		if (shouldStop())
+		if (shouldStop() || !reportErrors())
 		{
-			quit();
+			cancel();
 			return;
 		}
 
-		if (src.isDir() && !src.isSymLink())
-		{
-			qDebug() << "Create dir" << dst;
-
-			ret = d.mkpath(dst);
-
-		} else {
-			if (QFile::exists(dst))
-			{
-				switch (overwrite)
-				{
-				case FileCopierWorker::ASK:
-					emit fileExists(src, dst);
-					return;
-
-				case FileCopierWorker::NO:
-					overwrite = FileCopierWorker::ASK;
-					m_files.removeFirst();
-					continue;
-
-				case FileCopierWorker::ONCE:
-					QFile::remove(dst);
-					overwrite = FileCopierWorker::ASK;
-					break;
-
-				case FileCopierWorker::YES_ALL:
-					QFile::remove(dst);
-					break;
-
-				case FileCopierWorker::NO_ALL:
-					m_files.removeFirst();
-					continue;
-				}
-			}
+		const Entry &e = m_files[m_next];
+		const QString dst = QDir::cleanPath(e.dst);
 
-			qDebug() << "Copy" << src.absoluteFilePath() << "into" << dst;
+		// another source may be copied to the same destination right now
+		const bool dispatched = m_dispatched.contains(dst);
 
-			d.mkpath(QFileInfo(dst).absoluteDir().absolutePath());
-			file.setFileName(src.absoluteFilePath());
-			ret = file.copy(dst);
-
-			if (!ret)
-				qDebug() << file.error() << file.errorString();
-		}
-
-		if (!ret)
+		if (dispatched || QFile::exists(e.dst))
 		{
-			emit errorOccured(
-				tr("Unable to copy '%1': %2")
-				.arg(src.absoluteFilePath())
-				.arg(file.errorString())
-			);
-
-			if (m_stopOnError)
+			switch (overwrite)
 			{
-				quit();
+			case FileCopierWorker::ASK:
+				emit fileExists(e.src, e.dst);
 				return;
+
+			case FileCopierWorker::NO:
+				overwrite = FileCopierWorker::ASK;
+				m_skipped++;
+				m_skippedBytes += e.src.size();
+				m_next++;
+				continue;
+
+			case FileCopierWorker::ONCE:
+				if (dispatched)
+					waitForJobs();
+
+				QFile::remove(e.dst);
+				overwrite = FileCopierWorker::ASK;
+				break;
+
+			case FileCopierWorker::YES_ALL:
+				if (dispatched)
+					waitForJobs();
+
+				QFile::remove(e.dst);
+				break;
+
+			case FileCopierWorker::NO_ALL:
+				m_skipped++;
+				m_skippedBytes += e.src.size();
+				m_next++;
+				continue;
 			}
 		}
 
-		done = ++i / (double) m_files.size() * 100;
+		m_dispatched << dst;
+
+		FileCopyJob *job = new FileCopyJob(e.src.absoluteFilePath(), e.dst, m_stats);
+
+		if (e.src.size() >= FILE_COPY_LARGE_FILE)
+			m_largePool->start(job);
+		else
+			m_smallPool->start(job);
 
-		if (done > lastDone)
+		m_next++;
+		reportProgress(false);
+	}
+
+	while (!m_smallPool->waitForDone(FILE_COPY_REPORT_MSECS) || !m_largePool->waitForDone(FILE_COPY_REPORT_MSECS))
+	{
+		if (shouldStop() || !reportErrors())
 		{
-			lastDone = done;
-			emit progress(done, 100);
+			cancel();
+			return;
 		}
 
-		m_files.removeFirst();
+		reportProgress(false);
 	}
 
+	if (!reportErrors())
+	{
+		quit();
+		return;
+	}
+
+	reportProgress(true);
+
+	const double secs = qMax<qint64>(m_timer.elapsed(), 1) / 1000.0;
+	qDebug() << "Copied" << m_stats->files.load() << "files," << m_stats->bytes.load() << "bytes in"
+			 << secs << "s," << (m_stats->bytes.load() / 1048576.0 / secs) << "MB/s";
+
 	emit finished();
 }
 
 void FileCopierWorker::recurse(const QFileInfo &src, const QString &dst, const QString &subdir)
 {
-	m_files << QPair<QFileInfo, QString>(
-		src,
-		dst + "/" + subdir + "/" + src.fileName()
-	);
+	const QString target = dst + "/" + subdir + "/" + src.fileName();
 
 	if (!src.isDir())
+	{
+		m_dirs << QDir::cleanPath(dst + "/" + subdir);
+		addFile(src, target);
 		return;
+	}
+
+	m_dirs << QDir::cleanPath(target);
 
 	QDir root(src.absoluteFilePath());
 	QFileInfoList list = root.entryInfoList(
@@ -297,14 +369,105 @@ void FileCopierWorker::recurse(const QFileInfo &src, const QString &dst, const Q
 			return;
 
 		if (f.isDir())
+			recurse(f, target, QString());
+		else
+			addFile(f, target + "/" + f.fileName());
+	}
+}
+
+void FileCopierWorker::addFile(const QFileInfo &src, const QString &dst)
+{
+	Entry e;
+	e.src = src;
+	e.dst = dst;
+
+	m_files << e;
+	m_totalBytes += src.size();
+}
+
+bool FileCopierWorker::createDirectories()
+{
+	QDir d;
+
+	foreach (const QString &dir, m_dirs)
+	{
+		if (shouldStop())
+			return false;
+
+		if (!d.mkpath(dir))
 		{
-			recurse(f, dst + "/" + subdir + "/" + src.fileName(), QString());
+			emit errorOccured(tr("Unable to create directory '%1'").arg(dir));
 
-		} else {
-			m_files << QPair<QFileInfo, QString>(
-				f,
-				dst + "/" + subdir + "/" + src.fileName() + "/" + f.fileName()
-			);
+			if (m_stopOnError)
+				return false;
 		}
 	}
+
+	return true;
+}
+
+bool FileCopierWorker::reportErrors()
+{
+	QStringList errors;
+
+	{
+		QMutexLocker locker(&m_stats->mutex);
+		errors.swap(m_stats->errors);
+	}
+
+	// the first error is enough when the copying stops
+	if (m_stopOnError && !errors.isEmpty())
+		errors = errors.mid(0, 1);
+
+	foreach (const QString &error, errors)
+		emit errorOccured(error);
+
+	return !m_stopOnError || m_stats->failed.load() == 0;
+}
+
+void FileCopierWorker::reportProgress(bool force)
+{
+	if (!force && m_reportTimer.elapsed() < FILE_COPY_REPORT_MSECS)
+		return;
+
+	m_reportTimer.restart();
+
+	const int files = m_stats->files.load();
+	const qint64 bytes = m_stats->bytes.load();
+	const int count = m_files.count();
+
+	// processed files include the skipped and failed ones
+	const qint64 processed = files + m_skipped + m_stats->failed.load();
+	const qint64 total = m_totalBytes + qint64(count) * FILE_COPY_FILE_COST;
+	const qint64 done = bytes + m_skippedBytes + processed * FILE_COPY_FILE_COST;
+	const int percent = total > 0 ? qMin<qint64>(done * 100 / total, 100) : 100;
+
+	if (percent != m_lastProgress)
+	{
+		m_lastProgress = percent;
+		emit progress(percent, 100);
+	}
+
+	const double secs = qMax<qint64>(m_timer.elapsed(), 1) / 1000.0;
+
+	emit statusChanged(tr("Copied %1 of %2 files, %3 MB/s")
+					   .arg(files)
+					   .arg(count)
+					   .arg(bytes / 1048576.0 / secs, 0, 'f', 1));
+}
+
+void FileCopierWorker::waitForJobs()
+{
+	m_smallPool->waitForDone();
+	m_largePool->waitForDone();
+}
+
+void FileCopierWorker::cancel()
+{
+	m_smallPool->clear();
+	m_largePool->clear();
+	m_smallPool->waitForDone();
+	m_largePool->waitForDone();
+
+	quit();
 }
@@ -4,11 +4,20 @@
 #include <QObject>
 #include <QFileInfo>
 #include <QFileInfoList>
+#include <QVector>
+#include <QSet>
+#include <QMutex>
+#include <QRunnable>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QStringList>
 
 #include "threadworker.h"
 
 class ProgressDialog;
 class FileCopierWorker;
+class QThreadPool;
 
 /*! Wraps the actual working thread that is deleting files and reporting
  * progress.
@@ -41,10 +50,44 @@ private:
 
 private slots:
 	void progressUpdate(int done, int total);
+	void statusUpdate(const QString &status);
 	void directoryDeletionError(const QString &error);
 	void confirmOverwrite(const QFileInfo &src, const QString &dst);
 };
 
+//! Counters shared by FileCopyJob instances of one FileCopierWorker
+struct FileCopyStats
+{
+	QAtomicInteger<int> files;
+	QAtomicInteger<qint64> bytes;
+	QAtomicInteger<int> failed;
+	QMutex mutex;
+	//! Errors not reported yet
+	QStringList errors;
+};
+
+/*!
+ * \brief Copies one file by FileCopyEngine on the pool of FileCopierWorker
+ */
+class FileCopyJob : public QRunnable
+{
+public:
+	FileCopyJob(const QString &src, const QString &dst, QSharedPointer<FileCopyStats> stats);
+	void run();
+
+private:
+	QString m_src;
+	QString m_dst;
+	QSharedPointer<FileCopyStats> m_stats;
+};
+
+/*!
+ * \brief Copies files and directory trees
+ *
+ * All directories are created first, then the files are copied by
+ * FileCopyJob. Small files are copied in parallel, large files one
+ * at a time, so that they're read sequentially.
+ */
 class FileCopierWorker : public ThreadWorker
 {
 	Q_OBJECT
@@ -63,18 +106,49 @@ public:
 
 public slots:
 	void run();
-	void continueWork(Overwrite overwrite = ASK);
+	void continueWork(FileCopierWorker::Overwrite overwrite = ASK);
 
 signals:
 	void fileExists(const QFileInfo &src, const QString &dst);
+	//! Files copied and throughput
+	void statusChanged(const QString &status);
 
 private:
+	struct Entry {
+		QFileInfo src;
+		QString dst;
+	};
+
 	QList<QPair<QFileInfo,QString>> m_sourceFiles;
 	QString m_dst;
-	QList<QPair<QFileInfo, QString>> m_files;
+	QVector<Entry> m_files;
+	QSet<QString> m_dirs;
+	//! Destinations of started jobs, they may not exist yet
+	QSet<QString> m_dispatched;
+	//! Index of the next file in m_files
+	int m_next;
+	qint64 m_totalBytes;
+	int m_skipped;
+	qint64 m_skippedBytes;
 	bool m_stopOnError;
+	QThreadPool *m_smallPool;
+	QThreadPool *m_largePool;
+	QSharedPointer<FileCopyStats> m_stats;
+	QElapsedTimer m_timer;
+	QElapsedTimer m_reportTimer;
+	int m_lastProgress;
 
 	void recurse(const QFileInfo &src, const QString &dst, const QString &subdir);
+	void addFile(const QFileInfo &src, const QString &dst);
+	bool createDirectories();
+	//! Emit errors of finished jobs, returns false when the copying should stop
+	bool reportErrors();
+	void reportProgress(bool force);
+	//! Wait until all started jobs are finished
+	void waitForJobs();
+	void cancel();
 };
 
+Q_DECLARE_METATYPE(FileCopierWorker::Overwrite)
+
 #endif // FILECOPIER_H
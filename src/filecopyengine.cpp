@@ -0,0 +1,226 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+#include "filecopyengine.h"
+
+// Bytes copied by one system call
+#define FILE_COPY_CHUNK (16 * 1024 * 1024)
+// Buffer of the user space fallback
+#define FILE_COPY_BUFFER (1024 * 1024)
+
+#ifdef Q_OS_LINUX
+// Missing in headers older than Linux 4.5
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+
+/*!
+ * Copy the rest of \a in to \a out from their current offsets. Returns
+ * 1 when done, 0 when this way of copying is not supported and -1
+ * on other errors.
+ */
+static int copyRange(int in, int out, qint64 *copied)
+{
+#ifdef __NR_copy_file_range
+	// called directly, the glibc wrapper is missing before 2.27
+	for (;;)
+	{
+		const ssize_t n = syscall(__NR_copy_file_range, in, NULL, out, NULL, FILE_COPY_CHUNK, 0);
+
+		if (n == 0)
+			return 1;
+
+		if (n < 0)
+		{
+			// cross file system copies are not supported before Linux 5.3
+			if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)
+				return 0;
+
+			return -1;
+		}
+
+		*copied += n;
+	}
+#else
+	Q_UNUSED(in);
+	Q_UNUSED(out);
+	Q_UNUSED(copied);
+	return 0;
+#endif
+}
+
+static int copySendfile(int in, int out, qint64 *copied)
+{
+	for (;;)
+	{
+		const ssize_t n = sendfile(out, in, NULL, FILE_COPY_CHUNK);
+
+		if (n == 0)
+			return 1;
+
+		if (n < 0)
+			return (errno == EINVAL || errno == ENOSYS) ? 0 : -1;
+
+		*copied += n;
+	}
+}
+
+static int copyBuffered(int in, int out, qint64 *copied)
+{
+	QByteArray buffer(FILE_COPY_BUFFER, Qt::Uninitialized);
+
+	for (;;)
+	{
+		const ssize_t n = read(in, buffer.data(), buffer.size());
+
+		if (n == 0)
+			return 1;
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return -1;
+		}
+
+		for (ssize_t written = 0; written < n; )
+		{
+			const ssize_t w = write(out, buffer.constData() + written, n - written);
+
+			if (w < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				return -1;
+			}
+
+			written += w;
+		}
+
+		*copied += n;
+	}
+}
+
+static bool copyFile(const QString &src, const QString &dst, qint64 *copied, QString *error)
+{
+	const QByteArray dstPath = QFile::encodeName(dst);
+	const int in = open(QFile::encodeName(src).constData(), O_RDONLY | O_CLOEXEC);
+
+	if (in < 0)
+	{
+		*error = QString::fromLocal8Bit(strerror(errno));
+		return false;
+	}
+
+	struct stat st;
+
+	if (fstat(in, &st) != 0)
+	{
+		*error = QString::fromLocal8Bit(strerror(errno));
+		close(in);
+		return false;
+	}
+
+	const int out = open(dstPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+
+	if (out < 0)
+	{
+		*error = QString::fromLocal8Bit(strerror(errno));
+		close(in);
+		return false;
+	}
+
+	int ret;
+
+	if (st.st_size > 0 && ioctl(out, FICLONE, in) == 0)
+	{
+		*copied = st.st_size;
+		ret = 1;
+
+	} else {
+		ret = copyRange(in, out, copied);
+
+		// each fallback continues from where the previous one stopped
+		if (ret == 0)
+			ret = copySendfile(in, out, copied);
+
+		if (ret == 0)
+			ret = copyBuffered(in, out, copied);
+	}
+
+	if (ret == 1)
+	{
+		const struct timespec times[2] = { st.st_atim, st.st_mtim };
+		futimens(out, times);
+	}
+
+	if (ret != 1)
+		*error = QString::fromLocal8Bit(strerror(errno));
+
+	if (close(out) != 0 && ret == 1)
+	{
+		*error = QString::fromLocal8Bit(strerror(errno));
+		ret = -1;
+	}
+
+	close(in);
+
+	if (ret != 1)
+	{
+		unlink(dstPath.constData());
+		return false;
+	}
+
+	return true;
+}
+
+#else
+
+static bool copyFile(const QString &src, const QString &dst, qint64 *copied, QString *error)
+{
+	QFile file(src);
+
+	if (QFile::exists(dst))
+		QFile::remove(dst);
+
+	if (!file.copy(dst))
+	{
+		*error = file.errorString();
+		return false;
+	}
+
+#if QT_VERSION >= 0x050a00
+	// CopyFile() keeps the time, the generic implementation does not
+	QFile out(dst);
+
+	if (out.open(QIODevice::ReadWrite))
+		out.setFileTime(QFileInfo(src).lastModified(), QFileDevice::FileModificationTime);
+#endif
+
+	*copied = QFileInfo(dst).size();
+	return true;
+}
+
+#endif
+
+
+bool FileCopyEngine::copy(const QString &src, const QString &dst, qint64 *copied, QString *error)
+{
+	*copied = 0;
+	return copyFile(src, dst, copied, error);
+}
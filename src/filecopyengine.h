@@ -0,0 +1,29 @@
+#ifndef FILECOPYENGINE_H
+#define FILECOPYENGINE_H
+
+#include <QString>
+
+/*!
+ * \brief Copies single files with the cheapest mechanism of the platform
+ *
+ * On Linux the copy is first attempted as a reflink (FICLONE), which
+ * shares the data on btrfs, XFS and similar file systems. Then the data
+ * is copied within the kernel by copy_file_range() or sendfile(), and
+ * only when both are unavailable it goes through a user space buffer.
+ * Other platforms use QFile::copy(), which is CopyFile() on Windows.
+ *
+ * The modification time of the source is kept. It's safe to copy from
+ * several threads at once.
+ */
+class FileCopyEngine
+{
+public:
+	/*!
+	 * Copy \a src to \a dst, which is overwritten when it exists.
+	 * Bytes copied are stored in \a copied, the reason of a failure
+	 * in \a error.
+	 */
+	static bool copy(const QString &src, const QString &dst, qint64 *copied, QString *error);
+};
+
+#endif // FILECOPYENGINE_H
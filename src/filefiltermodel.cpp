@@ -19,20 +19,42 @@ void FileFilterModel::setShowProeVersions(bool show)
 	invalidate();
 }
 
+void FileFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+	if (this->sourceModel())
+		disconnect(this->sourceModel(), 0, this, 0);
+
+	QSortFilterProxyModel::setSourceModel(sourceModel);
+	clearColumns();
+
+	connect(sourceModel, SIGNAL(modelReset()),
+			this, SLOT(clearColumns()));
+	connect(sourceModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+			this, SLOT(sourceDataChanged(QModelIndex,QModelIndex)));
+}
+
 void FileFilterModel::filterColumn(int column, const QString &text)
 {
 	if (text.isEmpty())
 		m_filters.remove(column);
 
 	else
-		m_filters[column] = text;
+		m_filters[column] = ColumnMatcher(text, m_modes.value(column, ColumnMatcher::Substring));
 
 	beginResetModel();
 	endResetModel();
 }
 
+void FileFilterModel::setFilterMode(int column, int mode)
+{
+	// applied with the next filterColumn() call
+	m_modes[column] = (ColumnMatcher::Mode) mode;
+}
+
 void FileFilterModel::resetFilters()
 {
+	m_modes.clear();
+
 	if (m_filters.empty())
 		return;
 
@@ -46,38 +68,43 @@ bool FileFilterModel::filterAcceptsRow(int source_row, const QModelIndex& source
 	FileModel *fm = qobject_cast<FileModel*>(sourceModel());
 	Q_ASSERT(fm);
 
-	QModelIndex current = fm->index(source_row, 0, source_parent);
-	FileMetadata f(fm->fileInfo(current));
+	const int row = fm->partRowIndex(source_row, source_parent);
+
+	if (row == -1)
+		return false;
 
-	if (f.fileInfo.isDir())
+	// older versions are shown together with their latest version
+	if (source_parent.isValid())
+		return true;
+
+	const PartRow &part = fm->partRow(row);
+
+	if (part.isDir)
 	{
-		if (f.fileInfo.baseName() == METADATA_DIR)
+		if (part.baseName == METADATA_DIR)
 			return false;
 
 		return MetadataCache::get()->showDirectoriesAsParts(fm->path());
 	}
-	else if (!Settings::get()->filtersRegex.exactMatch(f.fileInfo.fileName()))
+	else if (!Settings::get()->filtersRegex.exactMatch(part.fileName))
 	{
 		return false;
 	}
-	else if (f.type == FileType::UNDEFINED)
+	else if (part.type == FileType::UNDEFINED)
 	{
 		return false;
 	}
 	else if (m_showProeVersions)
 	{
 		// now we know that it's supported file and we should not take care about versions
-		return isFiltered(fm->path(), f.fileInfo.baseName());
+		return isFiltered(row);
 	}
-	else if (File::versionedTypes().contains(f.type))
+	else if (!fm->versionIndex().isLatest(row))
 	{
-		MetadataVersionsMap versions = MetadataCache::get()->partVersions(fm->path());
-
-		return versions[f.fileInfo.completeBaseName()] == f.fileInfo.fileName()
-			   && isFiltered(fm->path(), f.fileInfo.baseName());
+		return false;
 	}
 
-	return isFiltered(fm->path(), f.fileInfo.baseName());
+	return isFiltered(row);
 }
 
 bool FileFilterModel::filterAcceptsColumn(int source_column, const QModelIndex & source_parent) const
@@ -90,36 +117,64 @@ bool FileFilterModel::filterAcceptsColumn(int source_column, const QModelIndex &
 	return true;
 }
 
-bool FileFilterModel::isFiltered(const QString &path, const QString &name) const
+bool FileFilterModel::isFiltered(int source_row) const
 {
 	if (m_filters.empty())
 		return true;
 
-	auto meta = MetadataCache::get();
-	QMap<int, QString>::const_iterator i = m_filters.constBegin();
+	QMap<int, ColumnMatcher>::const_iterator i = m_filters.constBegin();
 
 	while (i != m_filters.constEnd()) {
 		int col = i.key();
-		const QString &val = i.value();
 
-		if (col == 0) {
-			// Part name
-			if (!name.contains(val))
-				return false;
+		// Thumbnail column has no filter, this shouldn't happen
+		if (col != 1 && !foldedColumn(col).matches(source_row, i.value()))
+			return false;
+
+		++i;
+	}
 
-		} else if (col == 1) {
-			// Thumbnail
-			// This shouldn't happen, do nothing
+	return true;
+}
 
-		} else {
-			QString data = meta->partParam(path, name, col-2);
+const FoldedColumn &FileFilterModel::foldedColumn(int column) const
+{
+	if (m_columns.contains(column))
+		return m_columns[column];
 
-			if (!data.contains(val))
-				return false;
-		}
+	FileModel *fm = qobject_cast<FileModel*>(sourceModel());
+	Q_ASSERT(fm);
 
-		++i;
+	auto meta = MetadataCache::get();
+	// indexed by part rows, not by top level rows of grouped versions
+	const int rows = fm->partCount();
+	FoldedColumn &folded = m_columns[column];
+
+	folded.reserve(rows, rows * 16);
+
+	for (int row = 0; row < rows; row++)
+	{
+		const QString &name = fm->partRow(row).baseName;
+
+		if (column == 0)
+			// Part name
+			folded.append(name);
+
+		else
+			folded.append(meta->partParam(fm->path(), name, column-2));
 	}
 
-	return true;
+	return folded;
+}
+
+void FileFilterModel::clearColumns()
+{
+	m_columns.clear();
+}
+
+void FileFilterModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+	// only parameter columns are editable
+	for (int col = qMax(2, topLeft.column()); col <= bottomRight.column(); col++)
+		m_columns.remove(col);
 }
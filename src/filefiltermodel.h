@@ -3,6 +3,9 @@
 
 #include <QSortFilterProxyModel>
 #include <QMap>
+#include <QHash>
+
+#include "columnmatcher.h"
 
 class FileFilterModel : public QSortFilterProxyModel
 {
@@ -10,9 +13,11 @@ class FileFilterModel : public QSortFilterProxyModel
 public:
 	explicit FileFilterModel(QObject *parent = 0);
 	void setShowProeVersions(bool show);
+	void setSourceModel(QAbstractItemModel *sourceModel);
 
 public slots:
 	void filterColumn(int column, const QString &text);
+	void setFilterMode(int column, int mode);
 	void resetFilters();
 
 protected:
@@ -21,10 +26,17 @@ protected:
 
 private:
 	bool m_showProeVersions;
-	QMap<int, QString> m_filters;
+	QMap<int, ColumnMatcher> m_filters;
+	QMap<int, ColumnMatcher::Mode> m_modes;
+	//! Folded values of filtered columns, built once per directory
+	mutable QHash<int, FoldedColumn> m_columns;
 
-	bool isFiltered(const QString &path, const QString &name) const;
+	bool isFiltered(int source_row) const;
+	const FoldedColumn &foldedColumn(int column) const;
 
+private slots:
+	void clearColumns();
+	void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
 };
 
 #endif // FILEFILTERMODEL_H
@@ -21,6 +21,8 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QApplication>
+#include <QTimer>
+#include <algorithm>
 
 #include "filemodel.h"
 #include "settings.h"
@@ -29,35 +31,61 @@
 #include "filecopier.h"
 #include "partselector.h"
 #include "partcache.h"
+#include "iconcache.h"
 
 FileModel::FileModel(QObject *parent) :
-	QAbstractItemModel(parent)
+	QAbstractItemModel(parent),
+	m_groupVersions(Settings::get()->GroupProeVersions),
+	m_grouped(false)
 {
-	m_iconProvider = new FileIconProvider();
-    m_thumb = new ThumbnailManager(this);
-    connect(m_thumb, SIGNAL(updateModel()), this, SLOT(updateThumbnails()));
+	m_thumb = new ThumbnailManager(this);
+
+	// dataChanged() for new thumbnails is emitted at most once per frame
+	m_thumbnailTimer = new QTimer(this);
+	m_thumbnailTimer->setSingleShot(true);
+	m_thumbnailTimer->setInterval(16);
+
+	connect(m_thumbnailTimer, SIGNAL(timeout()), this, SLOT(updateThumbnails()));
+	connect(m_thumb, SIGNAL(thumbnailsReady(QStringList)),
+			this, SLOT(thumbnailsReady(QStringList)));
+	connect(m_thumb, SIGNAL(loadingFinished()), this, SLOT(thumbnailsLoaded()));
+	connect(m_thumb, SIGNAL(indexUpdated()), this, SIGNAL(thumbnailsListed()));
+	connect(m_thumb, SIGNAL(previewReady(QString)), this, SIGNAL(previewReady(QString)));
 	connect(PartCache::get(), SIGNAL(cleared(QString)),
 			this, SLOT(directoryCleared(QString)));
+	connect(PartSelector::get(), SIGNAL(selectionChanged(QString)),
+			this, SLOT(partSelectionChanged(QString)));
 	connect(PartCache::get(), SIGNAL(directoryRenamed(QString,QString)),
 			this, SLOT(directoryRenamed(QString,QString)));
 }
 
 FileModel::~FileModel()
 {
-	delete m_iconProvider;
 }
 
+/*
+ * When are the versions grouped, top level rows are the latest versions
+ * and older versions are their children. Internal id of top level
+ * indexes is 0, children have the parent's row + 1.
+ */
 QModelIndex FileModel::index(int row, int column,
                              const QModelIndex &parent) const
 {
-	Q_UNUSED(parent);
-	return createIndex(row, column);
+	if (row < 0 || column < 0)
+		return QModelIndex();
+
+	if (!parent.isValid())
+		return createIndex(row, column, quintptr(0));
+
+	return createIndex(row, column, quintptr(parent.row() + 1));
 }
 
 QModelIndex FileModel::parent(const QModelIndex &child) const
 {
-	Q_UNUSED(child);
-	return QModelIndex();
+	if (!child.isValid() || child.internalId() == 0)
+		return QModelIndex();
+
+	return createIndex(int(child.internalId() - 1), 0, quintptr(0));
 }
 
 int FileModel::columnCount(const QModelIndex & parent) const
@@ -68,18 +96,23 @@ int FileModel::columnCount(const QModelIndex & parent) const
 
 int FileModel::rowCount(const QModelIndex & parent) const
 {
-	if (!parent.column()) return 0;
-	return PartCache::get()->count(m_path);
+	if (!parent.isValid())
+		return m_grouped ? m_topRows.count() : m_rows.count();
+
+	if (!m_grouped || parent.column() != 0 || parent.internalId() != 0)
+		return 0;
+
+	return m_versions.versionRows(m_topRows[parent.row()]).count() - 1;
 }
 
 QVariant FileModel::data(const QModelIndex &index, int role) const
 {
-	auto pc = PartCache::get();
+	const int row = partRowIndex(index);
 
-	if (!index.isValid() || m_path.isEmpty() || !pc->count(m_path))
+	if (row == -1)
 		return QVariant();
 
-	QFileInfo part = pc->partAt(m_path, index.row());
+	const PartRow &part = m_rows[row];
 	const int col = index.column();
 
 	// first handle standard QFileSystemModel data
@@ -87,47 +120,32 @@ QVariant FileModel::data(const QModelIndex &index, int role) const
 	{
 		return PartSelector::get()->isSelected(
 			m_path,
-			part.absoluteFilePath()
+			part.absoluteFilePath
 		);
 	}
 	else if (col == 0 && role == Qt::DisplayRole)
 	{
-		return part.fileName();
+		return part.fileName;
 	}
 	else if (col == 0 && role == Qt::DecorationRole)
 	{
-		return m_iconProvider->icon(part);
+		return IconCache::get()->fileIcon(part.iconKey, part.fileInfo);
 	}
 	// custom columns:
 	// thumbnail
 	else if (col == 1)
 	{
-		QString key(part.baseName());
 		switch( role )
 		{
 		case Qt::DecorationRole:
-        {
-            // TODO/FIXME: this is quite slow. Think about optimization
-			FileMetadata m(part);
-            // generate thumbnail for image files
-            if (m.type == FileType::FILE_IMAGE)
-            {
-				return QPixmap(m.fileInfo.absoluteFilePath()).scaled(
-					Settings::get()->GUIThumbWidth,
-					Settings::get()->GUIThumbWidth,
-					Qt::KeepAspectRatio
-				);
-            }
-            else
-				return m_thumb->thumbnail(part);
-			break;
-        }
+			// image parts are decoded by the thumbnail manager as well
+			return m_thumb->thumbnail(part.fileInfo);
 		case Qt::SizeHintRole:
             return QSize(Settings::get()->GUIThumbWidth,
                          Settings::get()->GUIThumbWidth);
             break;
 		case Qt::ToolTipRole:
-			return m_thumb->tooltip(part);
+			return m_thumb->tooltip(part.fileInfo);
 			break;
 		}
 	} // additional metadata
@@ -135,7 +153,7 @@ QVariant FileModel::data(const QModelIndex &index, int role) const
 	{
 		return MetadataCache::get()->partParam(
 			m_path,
-			part.fileName(),
+			part.fileName,
 			m_parameterHandles[col - 2]
 		);
 	}
@@ -143,16 +161,119 @@ QVariant FileModel::data(const QModelIndex &index, int role) const
 	return QVariant();
 }
 
+void FileModel::thumbnailsReady(const QStringList &baseNames)
+{
+	foreach (const QString &name, baseNames)
+	{
+		auto it = m_baseNameRows.constFind(name);
+
+		while (it != m_baseNameRows.constEnd() && it.key() == name)
+		{
+			m_thumbnailRows << it.value();
+			++it;
+		}
+	}
+
+	// thumbnails already come in batches from ThumbnailCache
+	updateThumbnails();
+}
+
+bool FileModel::hasThumbnail(const QModelIndex &index)
+{
+	return m_thumb->hasThumbnail(fileInfo(index));
+}
+
+QPixmap FileModel::preview(const QModelIndex &index)
+{
+	return m_thumb->preview(fileInfo(index));
+}
+
+void FileModel::thumbnailSizeChanged()
+{
+	// loaded thumbnails of the same tier are only rescaled
+	m_thumb->updateTier();
+
+	// rows take the height of the new thumbnails
+	emit layoutAboutToBeChanged();
+	emit layoutChanged();
+}
+
+void FileModel::thumbnailsLoaded()
+{
+	// parts without thumbnails still display the "loading" image
+	for (int i = 0; i < m_rows.count(); i++)
+		m_thumbnailRows << i;
+
+	if (!m_thumbnailTimer->isActive())
+		m_thumbnailTimer->start();
+
+	emit thumbnailsListed();
+}
+
+void FileModel::partSelectionChanged(const QString &dir)
+{
+	if (dir != m_path || m_rows.isEmpty())
+		return;
+
+	const int top = rowCount(QModelIndex());
+
+	if (top == 0)
+		return;
+
+	emit dataChanged(index(0, 0), index(top - 1, 0), QVector<int>() << Qt::CheckStateRole);
+
+	if (!m_grouped)
+		return;
+
+	for (int i = 0; i < top; i++)
+	{
+		QModelIndex parent = index(i, 0);
+		const int children = rowCount(parent);
+
+		if (children > 0)
+			emit dataChanged(index(0, 0, parent), index(children - 1, 0, parent),
+							 QVector<int>() << Qt::CheckStateRole);
+	}
+}
+
 void FileModel::updateThumbnails()
 {
-    // TODO/FIXME: proper index subset for udpate
-    beginResetModel();
-    endResetModel();
+	if (m_thumbnailRows.isEmpty())
+		return;
+
+	QList<int> rows = m_thumbnailRows.values();
+	std::sort(rows.begin(), rows.end());
+	m_thumbnailRows.clear();
+
+	// emit one signal per continuous block of rows
+	QModelIndex first, last;
+
+	foreach (int row, rows)
+	{
+		QModelIndex ix = partIndex(row, 1);
+
+		if (!ix.isValid())
+			continue;
+
+		if (last.isValid() && ix.parent() == last.parent() && ix.row() == last.row() + 1)
+		{
+			last = ix;
+			continue;
+		}
+
+		if (first.isValid())
+			emit dataChanged(first, last);
+
+		first = last = ix;
+	}
+
+	if (first.isValid())
+		emit dataChanged(first, last);
 }
 
 QFileInfo FileModel::fileInfo(const QModelIndex &ix)
 {
-	return PartCache::get()->partAt(m_path, ix.row());
+	return m_rows[partRowIndex(ix)].fileInfo;
 }
 
 QFileInfoList FileModel::fileInfoList()
@@ -160,6 +281,146 @@ QFileInfoList FileModel::fileInfoList()
 	return PartCache::get()->parts(m_path);
 }
 
+int FileModel::partCount() const
+{
+	return m_rows.count();
+}
+
+const PartRow &FileModel::partRow(int row) const
+{
+	return m_rows[row];
+}
+
+int FileModel::partRowIndex(const QModelIndex &index) const
+{
+	if (!index.isValid())
+		return -1;
+
+	return partRowIndex(index.row(), index.parent());
+}
+
+int FileModel::partRowIndex(int row, const QModelIndex &parent) const
+{
+	if (!m_grouped)
+		return (!parent.isValid() && row < m_rows.count()) ? row : -1;
+
+	if (!parent.isValid())
+		return row < m_topRows.count() ? m_topRows[row] : -1;
+
+	if (parent.row() >= m_topRows.count())
+		return -1;
+
+	// children are older versions, the first one is the parent itself
+	QVector<int> versions = m_versions.versionRows(m_topRows[parent.row()]);
+
+	return row + 1 < versions.count() ? versions[row + 1] : -1;
+}
+
+QModelIndex FileModel::partIndex(int partRow, int column) const
+{
+	if (partRow < 0 || partRow >= m_rows.count())
+		return QModelIndex();
+
+	if (!m_grouped)
+		return index(partRow, column);
+
+	if (m_versions.isLatest(partRow))
+		return index(m_topOf[partRow], column);
+
+	const int top = m_topOf[m_versions.latestRow(partRow)];
+	const int child = m_versions.versionRows(partRow).indexOf(partRow) - 1;
+
+	return createIndex(child, column, quintptr(top + 1));
+}
+
+const PartVersionIndex &FileModel::versionIndex() const
+{
+	return m_versions;
+}
+
+void FileModel::requestThumbnails(const QList<int> &partRows)
+{
+	QList<QFileInfo> files;
+	files.reserve(partRows.count());
+
+	foreach (int row, partRows)
+	{
+		if (row >= 0 && row < m_rows.count())
+			files << m_rows[row].fileInfo;
+	}
+
+	m_thumb->request(files);
+}
+
+bool FileModel::groupVersions() const
+{
+	return m_groupVersions;
+}
+
+void FileModel::setGroupVersions(bool group)
+{
+	if (group == m_groupVersions)
+		return;
+
+	m_groupVersions = group;
+
+	beginResetModel();
+	buildRows();
+	endResetModel();
+}
+
+void FileModel::buildRows()
+{
+	m_rows.clear();
+	m_baseNameRows.clear();
+	m_thumbnailRows.clear();
+	m_topRows.clear();
+	m_topOf.clear();
+	m_versions = PartVersionIndex();
+	// versions can be grouped only when they're shown
+	m_grouped = m_groupVersions && Settings::get()->ShowProeVersions;
+
+	if (m_path.isEmpty())
+		return;
+
+	QFileInfoList parts = PartCache::get()->parts(m_path);
+	m_rows.reserve(parts.count());
+
+	foreach (const QFileInfo &fi, parts)
+	{
+		FileMetadata meta(fi);
+		PartRow row;
+
+		row.fileInfo = fi;
+		row.fileName = fi.fileName();
+		row.baseName = fi.baseName();
+		row.absoluteFilePath = fi.absoluteFilePath();
+		row.type = meta.type;
+		row.isDir = fi.isDir();
+
+		row.iconKey = IconCache::get()->fileIconKey(row.type, fi);
+
+		m_baseNameRows.insert(row.baseName, m_rows.count());
+		m_rows << row;
+	}
+
+	m_versions = PartCache::get()->versionIndex(m_path);
+
+	if (!m_grouped)
+		return;
+
+	m_topOf.fill(-1, m_rows.count());
+
+	for (int i = 0; i < m_rows.count(); i++)
+	{
+		if (!m_versions.isLatest(i))
+			continue;
+
+		m_topOf[i] = m_topRows.count();
+		m_topRows << i;
+	}
+}
+
 void FileModel::setupColumns(const QString &path)
 {
 	m_columnLabels.clear();
@@ -177,8 +438,14 @@ void FileModel::directoryCleared(const QString &dir)
 
 void FileModel::directoryRenamed(const QString &oldName, const QString &newName)
 {
-	if (oldName == m_path)
-		m_path = newName;
+	if (oldName != m_path)
+		return;
+
+	m_path = newName;
+
+	beginResetModel();
+	buildRows();
+	endResetModel();
 }
 
 Qt::ItemFlags FileModel::flags(const QModelIndex& index) const
@@ -194,13 +461,18 @@ Qt::ItemFlags FileModel::flags(const QModelIndex& index) const
 
 bool FileModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
-	QFileInfo part = fileInfo(index);
+	const int row = partRowIndex(index);
+
+	if (row == -1)
+		return false;
+
+	const PartRow &part = m_rows[row];
 
 	if (role == Qt::CheckStateRole)
 	{
 		PartSelector::get()->toggle(
 			m_path,
-			part.absoluteFilePath()
+			part.absoluteFilePath
 		);
 
 		emit dataChanged(index, index);
@@ -208,7 +480,7 @@ bool FileModel::setData(const QModelIndex &index, const QVariant &value, int rol
 
 	} else if (role == Qt::EditRole && index.column() > 1) {
 		MetadataCache::get()->metadata(m_path)->setPartParam(
-			part.fileName(),
+			part.fileName,
 			m_parameterHandles[ index.column() - 2 ],
 			value.toString()
 		);
@@ -241,6 +513,7 @@ void FileModel::setDirectory(const QString &path)
 		m_path = path;
 
 		beginResetModel();
+		buildRows();
 		endResetModel();
 
 		QApplication::restoreOverrideCursor();
@@ -260,7 +533,8 @@ void FileModel::refreshModel()
 	m_thumb->clear();
 
 	beginResetModel();
-    endResetModel();
+	buildRows();
+	endResetModel();
 
 	QApplication::restoreOverrideCursor();
 }
@@ -273,6 +547,14 @@ void FileModel::reloadParts()
 void FileModel::settingsChanged()
 {
 	//setDirectory(m_path);
+
+	// versions cannot stay grouped when they're hidden
+	if (m_grouped != (m_groupVersions && Settings::get()->ShowProeVersions))
+	{
+		beginResetModel();
+		buildRows();
+		endResetModel();
+	}
 }
 
 void FileModel::deleteParts(DirectoryRemover *rm)
@@ -292,21 +574,25 @@ void FileModel::deleteParts(DirectoryRemover *rm)
 	{
 		it.next();
 
-		QString dir = it.key();
-		QStringList parts = it.value();
+		const QString &dir = it.key();
+		const PartSelector::PartSet &parts = it.value();
 
 		foreach (const QString &fname, parts)
 		{
 			QFileInfo fi(fname);
 
-			if (!Settings::get()->ShowProeVersions
-					&& MetadataCache::get()->partVersions(m_path).contains(fi.completeBaseName()))
+			QVector<int> versions;
+
+			if (!Settings::get()->ShowProeVersions)
+				versions = pc->versionIndex(dir).versionRows(fi.completeBaseName());
+
+			if (!versions.isEmpty())
 			{
 				// When deleting Pro/E files, we need to find all part versions
-				QDir d(m_path);
-				deleteList << d.entryInfoList(
-					QStringList() << (fi.completeBaseName() + ".*")
-				);
+				const QFileInfoList &dirParts = pc->parts(dir);
+
+				foreach (int row, versions)
+					deleteList << dirParts[row];
 
 			} else {
 				deleteList << fi;
@@ -315,7 +601,7 @@ void FileModel::deleteParts(DirectoryRemover *rm)
 			if (fi.isDir())
 				MetadataCache::get()->clear(fname);
 
-			MetadataCache::get()->deletePart(m_path, fi.baseName());
+			MetadataCache::get()->deletePart(dir, fi.baseName());
 		}
 
 		clearList << dir;
@@ -334,6 +620,7 @@ void FileModel::deleteParts(DirectoryRemover *rm)
 void FileModel::copyToWorkingDir(FileCopier *cp)
 {
 	auto selector = PartSelector::get();
+	auto pc = PartCache::get();
 	auto it = selector->allSelectedIterator();
 
 	while (it.hasNext())
@@ -351,14 +638,28 @@ void FileModel::copyToWorkingDir(FileCopier *cp)
 		foreach (const QString &fname, it.value())
 		{
 			QFileInfo fi(fname);
-			cp->addSourceFile(fi);
+
+			QVector<int> versions;
+
+			if (!Settings::get()->ShowProeVersions)
+				versions = pc->versionIndex(key).versionRows(fi.completeBaseName());
+
+			if (!versions.isEmpty())
+			{
+				// Copy all versions grouped under the selected Pro/E part, like deleteParts()
+				const QFileInfoList &dirParts = pc->parts(key);
+
+				foreach (int row, versions)
+					cp->addSourceFile(dirParts[row]);
+
+			} else {
+				cp->addSourceFile(fi);
+			}
 
 			QString thumbPath = m_thumb->path(fi.baseName());
 
 			if (!thumbPath.isEmpty())
 				cp->addSourceFile(QFileInfo(thumbPath), THUMBNAILS_DIR);
-
-			selector->clear(key, fname);
 		}
 	}
 
@@ -383,12 +684,8 @@ QIcon FileIconProvider::icon ( IconType type ) const
 QIcon FileIconProvider::icon ( const QFileInfo & info ) const
 {
 	FileMetadata fi(info);
-	QString s = QString(":/gfx/icons/%1.png").arg(File::getInternalNameForFileType(fi.type));
-
-	if (QFile::exists(s))
-		return QPixmap(s);
 
-	return QFileIconProvider().icon(info).pixmap(64);
+	return IconCache::get()->fileIcon(fi.type, info);
 }
 
 QString FileIconProvider::type ( const QFileInfo & info ) const
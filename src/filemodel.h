@@ -23,12 +23,30 @@
 
 #include <QAbstractItemModel>
 #include <QFileIconProvider>
+#include <QVector>
+#include <QSet>
 #include "metadata.h"
 #include "thumbnailmanager.h"
+#include "partversionindex.h"
 
 class FileIconProvider;
 class DirectoryRemover;
 class FileCopier;
+class QTimer;
+
+/*! Display data of one part, prepared once per directory by FileModel
+ */
+struct PartRow
+{
+	QFileInfo fileInfo;
+	QString fileName;
+	QString baseName;
+	QString absoluteFilePath;
+	FileType::FileType type;
+	bool isDir;
+	//! Key of the decoration icon in IconCache
+	QString iconKey;
+};
 
 /*! A "list files" tree. This class is used inside FileView only
  */
@@ -68,25 +86,66 @@ public:
 
 	QFileInfo fileInfo(const QModelIndex &ix);
 	QFileInfoList fileInfoList();
+	//! Number of parts in PartCache::parts(), including grouped versions
+	int partCount() const;
+	const PartRow &partRow(int row) const;
+	//! Index into PartCache::parts() of a model index
+	int partRowIndex(const QModelIndex &index) const;
+	int partRowIndex(int row, const QModelIndex &parent) const;
+	//! Model index of a part from PartCache::parts()
+	QModelIndex partIndex(int partRow, int column = 0) const;
+	const PartVersionIndex &versionIndex() const;
+
+	//! Load thumbnails of part rows in this order, cancel other pending ones
+	void requestThumbnails(const QList<int> &partRows);
+	bool hasThumbnail(const QModelIndex &index);
+	//! Thumbnail in GUIPreviewWidth, null until previewReady()
+	QPixmap preview(const QModelIndex &index);
+	//! GUIThumbWidth changed, rescale thumbnails without reloading the parts
+	void thumbnailSizeChanged();
+
+	bool groupVersions() const;
+	//! Present older Pro/E versions as children of the latest version
+	void setGroupVersions(bool group);
 
 signals:
 	void directoryLoaded(const QString &path);
+	//! Available thumbnails are known, they can be requested now
+	void thumbnailsListed();
+	void previewReady(const QString &baseName);
 
 private:
 	QString m_path;
 	QStringList m_columnLabels;
 	QStringList m_parameterHandles;
 
-	FileIconProvider *m_iconProvider;
+	QVector<PartRow> m_rows;
+	PartVersionIndex m_versions;
+	bool m_groupVersions;
+	//! Versions are grouped in the current directory
+	bool m_grouped;
+	//! top level row -> part row, used only when grouped
+	QVector<int> m_topRows;
+	//! part row -> top level row, -1 for older versions
+	QVector<int> m_topOf;
+	//! base name -> rows, used to map thumbnails to rows
+	QMultiHash<QString, int> m_baseNameRows;
+	//! rows with changed thumbnails waiting for the next dataChanged()
+	QSet<int> m_thumbnailRows;
+	QTimer *m_thumbnailTimer;
 
     ThumbnailManager *m_thumb;
 
 	void setupColumns(const QString &path);
+	void buildRows();
 
 private slots:
 	void directoryCleared(const QString &dir);
 	void directoryRenamed(const QString &oldName, const QString &newName);
-    void updateThumbnails();
+	void thumbnailsReady(const QStringList &baseNames);
+	void thumbnailsLoaded();
+	void updateThumbnails();
+	void partSelectionChanged(const QString &dir);
 };
 
 /*! An icon provider for FileModel. It contains additional
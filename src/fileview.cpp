@@ -8,6 +8,9 @@
 #include "directoryremover.h"
 #include "filecopier.h"
 #include "partcache.h"
+#include "partselector.h"
+#include "thumbnailtooltip.h"
+#include "columnmatcher.h"
 
 #include <QMessageBox>
 #include <QProcess>
@@ -16,11 +19,30 @@
 #include <QMenu>
 #include <QHeaderView>
 #include <QShortcut>
+#include <QApplication>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QHelpEvent>
 #include <QtDebug>
 
 
+// Upper limit of rows measured when computing column widths
+#define COLUMN_WIDTH_SAMPLE 100
+// Minimal column width
+#define COLUMN_MIN_WIDTH 50
+// Number of directories with remembered view state
+#define VIEW_STATE_CACHE 16
+// Rows above and below the viewport with prefetched thumbnails, in pages
+#define THUMBNAIL_LOOKAHEAD 1
+// Up to this many parts matching a type-ahead prefix are mapped to the view,
+// more are found by walking the view from the current row
+#define PART_SEARCH_MAP_LIMIT 64
+
+
 FileView::FileView(QWidget *parent) :
-	QTreeView(parent)
+	QTreeView(parent),
+	m_resizingColumns(false),
+	m_viewStates(VIEW_STATE_CACHE)
 {
 	m_model = new FileModel(this);
 	m_proxy = new FileFilterModel(this);
@@ -36,9 +58,15 @@ FileView::FileView(QWidget *parent) :
 
 	connect(m_header, SIGNAL(filterColumn(int,QString)),
 			m_proxy, SLOT(filterColumn(int,QString)));
+	connect(m_header, SIGNAL(filterModeChanged(int,int)),
+			m_proxy, SLOT(setFilterMode(int,int)));
+	connect(m_header, SIGNAL(sectionResized(int,int,int)),
+			this, SLOT(rememberColumnWidth(int)));
 
 	setItemDelegate(new FileDelegate(this));
 	setEditTriggers(QAbstractItemView::SelectedClicked);
+	// a range of rows can be selected and checked at once
+	setSelectionMode(QAbstractItemView::ExtendedSelection);
 
 	setContextMenuPolicy(Qt::CustomContextMenu);
 
@@ -57,6 +85,31 @@ FileView::FileView(QWidget *parent) :
 			this, SLOT(showContextMenu(QPoint)));
 
 	connect(MetadataCache::get(), SIGNAL(cleared()), this, SLOT(refreshModel()));
+
+	m_thumbnailTimer = new QTimer(this);
+	m_thumbnailTimer->setSingleShot(true);
+	m_thumbnailTimer->setInterval(50);
+
+	connect(m_thumbnailTimer, SIGNAL(timeout()), this, SLOT(requestVisibleThumbnails()));
+	connect(m_proxy, SIGNAL(modelReset()), this, SLOT(scheduleThumbnails()));
+	connect(m_proxy, SIGNAL(layoutChanged()), this, SLOT(scheduleThumbnails()));
+	connect(m_proxy, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(scheduleThumbnails()));
+	connect(m_proxy, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(scheduleThumbnails()));
+	connect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(scheduleThumbnails()));
+	connect(m_model, SIGNAL(thumbnailsListed()), this, SLOT(scheduleThumbnails()));
+
+	m_toolTip = new ThumbnailToolTip(this);
+
+	connect(m_model, SIGNAL(previewReady(QString)), this, SLOT(previewReady(QString)));
+	// the tooltip's index follows its part, which may no longer be under the cursor
+	connect(m_proxy, SIGNAL(modelReset()), m_toolTip, SLOT(hidePreview()));
+	connect(m_proxy, SIGNAL(layoutChanged()), m_toolTip, SLOT(hidePreview()));
+	connect(m_proxy, SIGNAL(rowsRemoved(QModelIndex,int,int)), m_toolTip, SLOT(hidePreview()));
+	connect(m_proxy, SIGNAL(rowsInserted(QModelIndex,int,int)), m_toolTip, SLOT(hidePreview()));
+
+	QShortcut *goTo = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_G), this);
+	goTo->setContext(Qt::WidgetWithChildrenShortcut);
+	connect(goTo, SIGNAL(activated()), this, SLOT(goToPart()));
 }
 
 void FileView::setDirectory(const QString &path)
@@ -65,17 +118,82 @@ void FileView::setDirectory(const QString &path)
 	{
 		return;
 	}
+	saveViewState();
+
 	m_path = path;
 	// it has to be reset here because calling QFileSystemModel's reset
 	// or begin/end alternatives results in "/" as a root path
-	m_model->setDirectory(m_path);
 	m_proxy->resetFilters();
+	m_model->setDirectory(m_path);
 	//setRootIndex(m_proxy->mapFromSource(m_model->setRootPath(m_path)));
 	resizeColumnToContents();
 }
 
+void FileView::restoreDirectory(const QString &path)
+{
+	setDirectory(path);
+
+	ViewState *state = m_viewStates.object(path);
+
+	if (!state)
+		return;
+
+	m_header->setFilters(state->filters);
+	sortByColumn(state->sortColumn, state->sortOrder);
+
+	QModelIndex current = partIndex(state->currentPart);
+
+	if (current.isValid())
+		selectionModel()->setCurrentIndex(
+			current,
+			QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows
+		);
+
+	QModelIndex top = partIndex(state->topPart);
+
+	if (top.isValid())
+		scrollTo(top, QAbstractItemView::PositionAtTop);
+}
+
+void FileView::saveViewState()
+{
+	if (m_path.isEmpty() || m_model->path() != m_path)
+		return;
+
+	ViewState *state = new ViewState;
+	state->filters = m_header->filters();
+	state->sortColumn = m_header->sortIndicatorSection();
+	state->sortOrder = m_header->sortIndicatorOrder();
+
+	QModelIndex top = indexAt(QPoint(0, 0));
+
+	if (top.isValid())
+		state->topPart = fileInfo(top).fileName();
+
+	if (currentIndex().isValid())
+		state->currentPart = fileInfo(currentIndex()).fileName();
+
+	m_viewStates.insert(m_path, state);
+}
+
+//! View index of the part with \a fileName
+QModelIndex FileView::partIndex(const QString &fileName)
+{
+	if (fileName.isEmpty())
+		return QModelIndex();
+
+	int row = PartCache::get()->nameIndex(m_model->path()).find(fileName);
+
+	if (row == -1)
+		return QModelIndex();
+
+	return m_proxy->mapFromSource(m_model->partIndex(row));
+}
+
 void FileView::refreshModel()
 {
+	// columns may have changed
+	m_columnWidths.remove(m_path);
 	setDirectory(m_path);
     m_model->refreshModel();
 }
@@ -83,13 +201,102 @@ void FileView::refreshModel()
 void FileView::resizeColumnToContents()
 {
 	int columnCnt = m_model->columnCount(QModelIndex());
+	QList<int> widths = m_columnWidths.value(m_path);
+
+	if (widths.count() != columnCnt)
+	{
+		widths = measureColumnWidths();
+		m_columnWidths.insert(m_path, widths);
+	}
+
+	m_resizingColumns = true;
+
 	for (int i = 0; i < columnCnt; i++)
+		setColumnWidth(i, widths[i]);
+
+	m_resizingColumns = false;
+}
+
+void FileView::rememberColumnWidth(int column)
+{
+	if (m_resizingColumns || !m_columnWidths.contains(m_path))
+		return;
+
+	QList<int> &widths = m_columnWidths[m_path];
+
+	if (column < widths.count())
+		widths[column] = columnWidth(column);
+}
+
+/*!
+ * Rows used for column width computation: rows currently visible
+ * in the viewport plus evenly spaced rows from the rest of the directory.
+ * Returns rows of the proxy model.
+ */
+QList<int> FileView::sampleRows() const
+{
+	QList<int> rows;
+	int rowCnt = m_proxy->rowCount();
+
+	if (rowCnt <= COLUMN_WIDTH_SAMPLE)
+	{
+		for (int i = 0; i < rowCnt; i++)
+			rows << i;
+
+		return rows;
+	}
+
+	QModelIndex top = indexAt(viewport()->rect().topLeft());
+	QModelIndex bottom = indexAt(viewport()->rect().bottomLeft());
+	int first = top.isValid() ? top.row() : 0;
+	int last = bottom.isValid() ? bottom.row() : qMin(first + COLUMN_WIDTH_SAMPLE / 2, rowCnt) - 1;
+
+	for (int i = first; i <= last && rows.count() < COLUMN_WIDTH_SAMPLE / 2; i++)
+		rows << i;
+
+	int step = rowCnt / (COLUMN_WIDTH_SAMPLE - rows.count());
+
+	for (int i = 0; i < rowCnt && rows.count() < COLUMN_WIDTH_SAMPLE; i += step)
+	{
+		if (i < first || i > last)
+			rows << i;
+	}
+
+	return rows;
+}
+
+QList<int> FileView::measureColumnWidths() const
+{
+	QList<int> widths;
+	QList<int> rows = sampleRows();
+	QStyleOptionViewItem opt = viewOptions();
+	int columnCnt = m_model->columnCount(QModelIndex());
+
+	for (int col = 0; col < columnCnt; col++)
 	{
-		QTreeView::resizeColumnToContents(i);
+		int w = m_header->sectionSizeHint(col);
+
+		if (col == 1)
+		{
+			// thumbnails are of fixed size
+			w = qMax(w, Settings::get()->GUIThumbWidth);
+
+		} else {
+			foreach (int row, rows)
+			{
+				QModelIndex ix = m_proxy->index(row, col);
+				w = qMax(w, itemDelegate(ix)->sizeHint(opt, ix).width());
+			}
+		}
+
+		if (col == 0)
+			w += indentation();
+
 		// hack. Probably some QFontMetrics for header should be used. But not urgent for now.
-		if (columnWidth(i) < 50)
-			setColumnWidth(i, 50);
+		widths << qMax(w, COLUMN_MIN_WIDTH);
 	}
+
+	return widths;
 }
 
 void FileView::settingsChanged()
@@ -99,6 +306,11 @@ void FileView::settingsChanged()
 	refreshModel();
 }
 
+void FileView::thumbnailSizeChanged()
+{
+	m_model->thumbnailSizeChanged();
+}
+
 QFileInfo FileView::fileInfo(const QModelIndex &filteredIndex)
 {
 	QModelIndex ix = m_proxy->mapToSource(filteredIndex);
@@ -177,24 +389,273 @@ void FileView::scrollContentsBy(int dx, int dy)
 
 	if (dx != 0)
 		m_header->fixComboPositions();
+
+	if (dy != 0)
+		scheduleThumbnails();
+}
+
+void FileView::resizeEvent(QResizeEvent *event)
+{
+	QTreeView::resizeEvent(event);
+	scheduleThumbnails();
+}
+
+/*!
+ * Thumbnails have their own tooltip with the preview from ThumbnailCache,
+ * other tooltips are left to the model.
+ */
+bool FileView::viewportEvent(QEvent *event)
+{
+	switch (event->type())
+	{
+	case QEvent::ToolTip:
+	{
+		QHelpEvent *he = static_cast<QHelpEvent*>(event);
+		QModelIndex ix = indexAt(he->pos());
+
+		if (ix.isValid() && ix.column() == 1)
+		{
+			QModelIndex src = m_proxy->mapToSource(ix);
+
+			if (m_model->hasThumbnail(src))
+			{
+				if (ix != m_toolTip->index())
+					m_toolTip->showPreview(ix, he->globalPos(), m_model->preview(src));
+
+				return true;
+			}
+		}
+
+		m_toolTip->hidePreview();
+		break;
+	}
+
+	case QEvent::Leave:
+	case QEvent::MouseButtonPress:
+	case QEvent::Wheel:
+		m_toolTip->hidePreview();
+		break;
+
+	default:
+		break;
+	}
+
+	return QTreeView::viewportEvent(event);
+}
+
+void FileView::previewReady(const QString &baseName)
+{
+	QModelIndex ix = m_toolTip->index();
+
+	if (!ix.isValid() || fileInfo(ix).baseName() != baseName)
+		return;
+
+	m_toolTip->updatePreview(ix, m_model->preview(m_proxy->mapToSource(ix)));
+}
+
+void FileView::scheduleThumbnails()
+{
+	m_thumbnailTimer->start();
+}
+
+/*!
+ * Request thumbnails of visible rows first, then of the rows around
+ * the viewport, the closest first. Everything else is cancelled.
+ */
+void FileView::requestVisibleThumbnails()
+{
+	if (isColumnHidden(1))
+		return;
+
+	QModelIndex top = indexAt(QPoint(0, 0));
+
+	if (!top.isValid())
+		return;
+
+	QList<QModelIndex> indexes;
+	QModelIndex ix = top;
+	const int height = viewport()->height();
+
+	while (ix.isValid() && visualRect(ix).top() < height)
+	{
+		indexes << ix;
+		ix = indexBelow(ix);
+	}
+
+	const int lookahead = qMax(1, indexes.count()) * THUMBNAIL_LOOKAHEAD;
+	QModelIndex above = indexAbove(top);
+	QModelIndex below = ix;
+
+	for (int i = 0; i < lookahead && (above.isValid() || below.isValid()); i++)
+	{
+		if (below.isValid())
+		{
+			indexes << below;
+			below = indexBelow(below);
+		}
+
+		if (above.isValid())
+		{
+			indexes << above;
+			above = indexAbove(above);
+		}
+	}
+
+	QList<int> rows;
+	rows.reserve(indexes.count());
+
+	foreach (const QModelIndex &index, indexes)
+		rows << m_model->partRowIndex(m_proxy->mapToSource(index));
+
+	m_model->requestThumbnails(rows);
 }
 
 QModelIndex FileView::findNextPartIndex(const QModelIndex &from)
 {
-	QString name = fileInfo(from).baseName();
+	const PartNameIndex &nameIndex = PartCache::get()->nameIndex(m_model->path());
+	const int group = nameIndex.group(m_model->partRowIndex(m_proxy->mapToSource(from)));
+	// the group contains all versions of the part, no need to look any further
+	const int maxSkip = nameIndex.groupRows(group).count();
 	QModelIndex index = from;
 
-	while (true) {
-		index = indexBelow(index);
+	for (int i = 0; i < maxSkip; i++) {
+		index = m_proxy->index(index.row() + 1, from.column(), from.parent());
 
 		if (!index.isValid())
 			return index;
 
-		if (fileInfo(index).baseName() == name)
+		if (nameIndex.group(m_model->partRowIndex(m_proxy->mapToSource(index))) != group)
+			return index;
+	}
+
+	return index;
+}
+
+/*!
+ * Find the part with the name starting with \a prefix. The first matching
+ * part at or below \a fromRow is returned, or the first matching part
+ * in the view if there is none below.
+ */
+QModelIndex FileView::findPartIndex(const QString &prefix, int fromRow)
+{
+	const PartNameIndex &nameIndex = PartCache::get()->nameIndex(m_model->path());
+	QPair<int, int> range = nameIndex.prefixRange(prefix);
+
+	if (range.first == range.second)
+		return QModelIndex();
+
+	// Many parts match a short prefix, the nearest one is just a few rows away
+	if (range.second - range.first > PART_SEARCH_MAP_LIMIT)
+		return walkPartIndex(prefix, fromRow);
+
+	QModelIndex below, first;
+
+	for (int pos = range.first; pos < range.second; pos++)
+	{
+		QModelIndex ix = m_proxy->mapFromSource(m_model->partIndex(nameIndex.rowAt(pos)));
+
+		// only top level parts, older grouped versions are skipped
+		if (!ix.isValid() || ix.parent().isValid())
 			continue;
 
-		return index;
+		if (ix.row() >= fromRow && (!below.isValid() || ix.row() < below.row()))
+			below = ix;
+
+		if (!first.isValid() || ix.row() < first.row())
+			first = ix;
+
+		if (below.isValid() && below.row() == fromRow)
+			break;
+	}
+
+	return below.isValid() ? below : first;
+}
+
+/*!
+ * Walk top level rows of the view from \a fromRow, wrapping around,
+ * until a part starting with \a prefix is found.
+ */
+QModelIndex FileView::walkPartIndex(const QString &prefix, int fromRow)
+{
+	const QString key = ColumnMatcher::fold(prefix);
+	const int cnt = m_proxy->rowCount();
+
+	for (int i = 0; i < cnt; i++)
+	{
+		QModelIndex ix = m_proxy->index((qMax(fromRow, 0) + i) % cnt, 0);
+		int row = m_model->partRowIndex(m_proxy->mapToSource(ix));
+
+		if (row != -1 && ColumnMatcher::fold(m_model->partRow(row).fileName).startsWith(key))
+			return ix;
+	}
+
+	return QModelIndex();
+}
+
+void FileView::selectPart(const QModelIndex &index)
+{
+	if (!index.isValid())
+		return;
+
+	selectionModel()->setCurrentIndex(
+		index,
+		QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows
+	);
+	scrollTo(index);
+}
+
+void FileView::keyboardSearch(const QString &search)
+{
+	if (search.isEmpty() || m_model->path().isEmpty())
+		return;
+
+	bool restart = !m_keyboardTimer.isValid()
+			|| m_keyboardTimer.elapsed() > QApplication::keyboardInputInterval();
+
+	m_keyboardTimer.start();
+
+	if (restart)
+		m_keyboardInput = search;
+	else
+		m_keyboardInput += search;
+
+	int current = currentIndex().isValid() ? currentIndex().row() : -1;
+
+	// a new search starts below the current part, continued one includes it
+	selectPart(findPartIndex(m_keyboardInput, restart ? current + 1 : qMax(current, 0)));
+}
+
+void FileView::goToPart()
+{
+	bool ok;
+	QString name = QInputDialog::getText(
+		this,
+		tr("Go to part"),
+		tr("Part name:"),
+		QLineEdit::Normal,
+		QString(),
+		&ok
+	);
+
+	if (!ok || name.isEmpty())
+		return;
+
+	QModelIndex index;
+	int row = PartCache::get()->nameIndex(m_model->path()).find(name);
+
+	if (row != -1)
+		index = m_proxy->mapFromSource(m_model->partIndex(row));
+
+	if (!index.isValid())
+		index = findPartIndex(name, 0);
+
+	if (!index.isValid())
+	{
+		QMessageBox::information(this, tr("Go to part"), tr("Part %1 not found").arg(name));
+		return;
 	}
+
+	selectPart(index);
 }
 
 void FileView::handleActivated(const QModelIndex &index)
@@ -260,10 +721,96 @@ void FileView::showContextMenu(const QPoint &point)
 
 	menu->addAction(QIcon(":/gfx/document-edit.png"), tr("Edit"),
 					this, SLOT(editFile()));
+
+	QAction *group = menu->addAction(tr("Group part versions"),
+									 this, SLOT(setGroupVersions(bool)));
+	group->setCheckable(true);
+	group->setChecked(m_model->groupVersions());
+	group->setEnabled(Settings::get()->ShowProeVersions);
+
+	menu->addSeparator();
+	menu->addAction(tr("Check all"), this, SLOT(checkAll()));
+	menu->addAction(tr("Check selected"), this, SLOT(checkSelected()));
+	menu->addAction(tr("Invert checked"), this, SLOT(invertChecked()));
+	menu->addAction(tr("Uncheck all"), this, SLOT(uncheckAll()));
+
 	menu->exec(mapToGlobal(point));
 	menu->deleteLater();
 }
 
+void FileView::setGroupVersions(bool group)
+{
+	Settings::get()->GroupProeVersions = group;
+	m_model->setGroupVersions(group);
+	m_columnWidths.remove(m_path);
+}
+
+/*!
+ * Paths of parts shown in the view, i.e. accepted by the filters.
+ * Only selected rows are returned when \a selectedOnly is true.
+ */
+QStringList FileView::visiblePartPaths(bool selectedOnly) const
+{
+	QStringList ret;
+	QModelIndexList indexes;
+
+	if (selectedOnly)
+	{
+		indexes = selectionModel()->selectedRows();
+
+	} else {
+		QList<QModelIndex> parents;
+		parents << QModelIndex();
+
+		while (!parents.isEmpty())
+		{
+			QModelIndex parent = parents.takeFirst();
+			const int rows = m_proxy->rowCount(parent);
+
+			for (int i = 0; i < rows; i++)
+			{
+				QModelIndex ix = m_proxy->index(i, 0, parent);
+				indexes << ix;
+
+				if (m_proxy->hasChildren(ix))
+					parents << ix;
+			}
+		}
+	}
+
+	ret.reserve(indexes.count());
+
+	foreach (const QModelIndex &ix, indexes)
+	{
+		int row = m_model->partRowIndex(m_proxy->mapToSource(ix));
+
+		if (row != -1)
+			ret << m_model->partRow(row).absoluteFilePath;
+	}
+
+	return ret;
+}
+
+void FileView::checkAll()
+{
+	PartSelector::get()->select(m_model->path(), visiblePartPaths(false));
+}
+
+void FileView::checkSelected()
+{
+	PartSelector::get()->select(m_model->path(), visiblePartPaths(true));
+}
+
+void FileView::invertChecked()
+{
+	PartSelector::get()->invert(m_model->path(), visiblePartPaths(false));
+}
+
+void FileView::uncheckAll()
+{
+	PartSelector::get()->clear(m_model->path());
+}
+
 void FileView::editFile()
 {
 	QModelIndex index = currentIndex();
@@ -2,10 +2,16 @@
 #define FILEVIEW_H
 
 #include <QTreeView>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QCache>
+#include <QTimer>
+
+#include "fileviewheader.h"
 
-class FileViewHeader;
 class FileModel;
 class FileFilterModel;
+class ThumbnailToolTip;
 class QFileInfo;
 
 
@@ -20,6 +26,7 @@ public:
 	void deleteParts();
 	void refreshRequested();
 	QString currentPath();
+	void keyboardSearch(const QString &search);
 
 signals:
 	void previewProductView(const QFileInfo &fi);
@@ -28,28 +35,73 @@ signals:
 
 public slots:
 	void setDirectory(const QString &path);
+	//! Set directory and restore its view state if it was visited recently
+	void restoreDirectory(const QString &path);
 	void settingsChanged();
+	//! GUIThumbWidth changed
+	void thumbnailSizeChanged();
 	void copyToWorkingDir();
 	void directoryChanged();
+	void goToPart();
 
 protected:
 	void scrollContentsBy(int dx, int dy);
+	void resizeEvent(QResizeEvent *event);
+	bool viewportEvent(QEvent *event);
 
 private:
 	QString m_path;
 	FileModel *m_model;
 	FileFilterModel *m_proxy;
 	FileViewHeader *m_header;
+	//! Column widths remembered per directory
+	QHash<QString, QList<int> > m_columnWidths;
+	bool m_resizingColumns;
+	QString m_keyboardInput;
+	QElapsedTimer m_keyboardTimer;
+
+	//! State of a recently visited directory, restored by restoreDirectory()
+	struct ViewState {
+		QMap<int, FileViewHeader::ColumnFilter> filters;
+		int sortColumn;
+		Qt::SortOrder sortOrder;
+		//! file names of the first visible and the current part
+		QString topPart;
+		QString currentPart;
+	};
+	QCache<QString, ViewState> m_viewStates;
+
+	//! Delays requestVisibleThumbnails() while scrolling
+	QTimer *m_thumbnailTimer;
+	ThumbnailToolTip *m_toolTip;
+
+	void saveViewState();
+	QModelIndex partIndex(const QString &fileName);
 
 	QModelIndex findNextPartIndex(const QModelIndex &from);
+	QModelIndex findPartIndex(const QString &prefix, int fromRow);
+	QModelIndex walkPartIndex(const QString &prefix, int fromRow);
+	void selectPart(const QModelIndex &index);
+	QStringList visiblePartPaths(bool selectedOnly) const;
+	QList<int> sampleRows() const;
+	QList<int> measureColumnWidths() const;
 
 private slots:
 	void resizeColumnToContents();
+	void scheduleThumbnails();
+	void requestVisibleThumbnails();
+	void previewReady(const QString &baseName);
+	void rememberColumnWidth(int column);
 	void refreshModel();
 	void handleActivated(const QModelIndex &index);
 	void openPart(const QModelIndex &index);
 	void showContextMenu(const QPoint &point);
 	void editFile();
+	void setGroupVersions(bool group);
+	void checkAll();
+	void checkSelected();
+	void invertChecked();
+	void uncheckAll();
 	void directoryRenamed(const QString &oldName, const QString &newName);
 };
 
@@ -3,6 +3,9 @@
 
 #include <QHBoxLayout>
 #include <QLineEdit>
+#include <QAction>
+#include <QMenu>
+#include <QStyle>
 #include <QDebug>
 
 FileViewHeader::FileViewHeader(FileModel *model, QWidget *parent) :
@@ -22,8 +25,52 @@ FileViewHeader::FileViewHeader(FileModel *model, QWidget *parent) :
 
 	m_mapper = new QSignalMapper(this);
 	connect(m_mapper, SIGNAL(mapped(int)), this, SLOT(filter(int)));
+
+	m_modeMapper = new QSignalMapper(this);
+	connect(m_modeMapper, SIGNAL(mapped(int)), this, SLOT(showModeMenu(int)));
+}
+
+
+QMap<int, FileViewHeader::ColumnFilter> FileViewHeader::filters() const
+{
+	QMap<int, ColumnFilter> ret;
+	QMap<int, QLineEdit*>::const_iterator i = m_edits.constBegin();
+
+	while (i != m_edits.constEnd()) {
+		if (!i.value()->text().isEmpty())
+		{
+			ColumnFilter f;
+			f.text = i.value()->text();
+			f.mode = m_modes.value(i.key(), ColumnMatcher::Substring);
+
+			ret[i.key()] = f;
+		}
+		++i;
+	}
+
+	return ret;
 }
 
+void FileViewHeader::setFilters(const QMap<int, ColumnFilter> &filters)
+{
+	QMap<int, ColumnFilter>::const_iterator i = filters.constBegin();
+
+	while (i != filters.constEnd()) {
+		QLineEdit *edit = m_edits.value(i.key());
+
+		if (edit)
+		{
+			m_modes[i.key()] = i.value().mode;
+
+			foreach (QAction *act, edit->actions())
+				act->setToolTip(ColumnMatcher::modeLabel(i.value().mode));
+
+			emit filterModeChanged(i.key(), i.value().mode);
+			edit->setText(i.value().text);
+		}
+		++i;
+	}
+}
 
 void FileViewHeader::newDirectory(const QString &path)
 {
@@ -72,6 +119,7 @@ void FileViewHeader::clearFields()
 		edit->deleteLater();
 
 	m_edits.clear();
+	m_modes.clear();
 }
 
 void FileViewHeader::createFields()
@@ -91,6 +139,15 @@ void FileViewHeader::createFields()
 		connect(edit, SIGNAL(textChanged(QString)), m_mapper, SLOT(map()));
 		m_mapper->setMapping(edit, i);
 
+		QAction *mode = edit->addAction(
+			style()->standardIcon(QStyle::SP_FileDialogContentsView),
+			QLineEdit::LeadingPosition
+		);
+		mode->setToolTip(ColumnMatcher::modeLabel(ColumnMatcher::Substring));
+
+		connect(mode, SIGNAL(triggered()), m_modeMapper, SLOT(map()));
+		m_modeMapper->setMapping(mode, i);
+
 		m_edits[i] = edit;
 	}
 }
@@ -145,7 +202,53 @@ void FileViewHeader::handleSectionMoved(int logical, int oldVisualIndex, int new
 
 void FileViewHeader::filter(int column)
 {
-	emit filterColumn(column, m_edits[column]->text());
+	QLineEdit *edit = m_edits[column];
+	QString text = edit->text();
+	ColumnMatcher::Mode mode = m_modes.value(column, ColumnMatcher::Substring);
+
+	if (!text.isEmpty() && !ColumnMatcher(text, mode).isValid())
+	{
+		edit->setStyleSheet("color: red;");
+		return;
+	}
+
+	edit->setStyleSheet(QString());
+	emit filterColumn(column, text);
+}
+
+void FileViewHeader::showModeMenu(int column)
+{
+	QLineEdit *edit = m_edits[column];
+	ColumnMatcher::Mode current = m_modes.value(column, ColumnMatcher::Substring);
+	QMenu menu(this);
+
+	for (int i = 0; i < ColumnMatcher::ModeCount; i++)
+	{
+		QAction *act = menu.addAction(ColumnMatcher::modeLabel((ColumnMatcher::Mode) i));
+		act->setData(i);
+		act->setCheckable(true);
+		act->setChecked(i == current);
+	}
+
+	QAction *selected = menu.exec(edit->mapToGlobal(edit->rect().bottomLeft()));
+
+	if (!selected)
+		return;
+
+	ColumnMatcher::Mode mode = (ColumnMatcher::Mode) selected->data().toInt();
+
+	if (mode == current)
+		return;
+
+	m_modes[column] = mode;
+
+	foreach (QAction *act, edit->actions())
+		act->setToolTip(ColumnMatcher::modeLabel(mode));
+
+	emit filterModeChanged(column, mode);
+
+	// re-validate the pattern for the new mode
+	filter(column);
 }
 
 void FileViewHeader::sortIndicatorChange(int logicalIndex, Qt::SortOrder order)
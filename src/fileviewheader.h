@@ -7,6 +7,8 @@
 #include <QLineEdit>
 #include <QSignalMapper>
 
+#include "columnmatcher.h"
+
 class FileModel;
 
 /*!
@@ -14,7 +16,8 @@ class FileModel;
  *
  * The QHeaderView is extended with a filtering mode. When the search
  * mode is enabled, each column header will contain a line edit for
- * searched content.
+ * searched content. The matching mode (substring, prefix, wildcard
+ * or regular expression) can be chosen per column.
  *
  * This solution is based on the following blog post:
  *
@@ -24,14 +27,25 @@ class FileViewHeader : public QHeaderView
 {
 	Q_OBJECT
 public:
+	struct ColumnFilter {
+		QString text;
+		ColumnMatcher::Mode mode;
+	};
+
 	FileViewHeader(FileModel *model, QWidget *parent = 0);
 
+	//! Non-empty filters of all columns
+	QMap<int, ColumnFilter> filters() const;
+	//! Fill the filter fields, emits filterModeChanged() and filterColumn()
+	void setFilters(const QMap<int, ColumnFilter> &filters);
+
 public slots:
 	void newDirectory(const QString &path);
 	void fixComboPositions();
 
 signals:
 	void filterColumn(int column, const QString &text);
+	void filterModeChanged(int column, int mode);
 
 protected:
 	QSize sizeHint() const;
@@ -40,7 +54,9 @@ protected:
 private:
 	FileModel *m_model;
 	QMap<int, QLineEdit*> m_edits;
+	QMap<int, ColumnMatcher::Mode> m_modes;
 	QSignalMapper *m_mapper;
+	QSignalMapper *m_modeMapper;
 
 	void clearFields();
 	void createFields();
@@ -51,6 +67,7 @@ private slots:
 	void handleSectionResized(int i);
 	void handleSectionMoved(int logical, int oldVisualIndex, int newVisualIndex);
 	void filter(int column);
+	void showModeMenu(int column);
 	void sortIndicatorChange(int logicalIndex, Qt::SortOrder order);
 };
 
@@ -0,0 +1,173 @@
+#include "iconcache.h"
+#include "settings.h"
+
+#include <QFile>
+#include <QGuiApplication>
+
+// Size of system icons in FileModel
+#define FILE_ICON_SIZE 64
+// Size of system icons in DataSourceModel
+#define DIRECTORY_ICON_SIZE 32
+
+IconCache* IconCache::m_instance = nullptr;
+
+IconCache *IconCache::get()
+{
+	if (!m_instance)
+		m_instance = new IconCache;
+
+	return m_instance;
+}
+
+void IconCache::warmUp()
+{
+	if (!m_builtin.isEmpty())
+		return;
+
+	m_builtin.fill(false, FileType::TYPES_COUNT);
+
+	for (int i = 0; i < FileType::TYPES_COUNT; i++)
+	{
+		QString name = File::getInternalNameForFileType((FileType::FileType) i);
+		QString path = QString(":/gfx/icons/%1.png").arg(name);
+
+		if (!QFile::exists(path))
+			continue;
+
+		m_builtin[i] = true;
+		m_fileIcons.insert(name, QPixmap(path));
+	}
+}
+
+QString IconCache::fileIconKey(FileType::FileType type, const QFileInfo &fi)
+{
+	warmUp();
+
+	if (fi.isDir())
+		return "/";
+
+	if (type != FileType::UNDEFINED && type < FileType::TYPES_COUNT && m_builtin[type])
+		return File::getInternalNameForFileType(type);
+
+	// the rest is left to the system, that differs only by suffix
+	return "." + fi.suffix().toLower();
+}
+
+QPixmap IconCache::fileIcon(const QString &key, const QFileInfo &fi)
+{
+	// builtin icons
+	auto it = m_fileIcons.constFind(key);
+
+	if (it != m_fileIcons.constEnd())
+		return it.value();
+
+	const QString sysKey = systemIconKey(key);
+	it = m_fileIcons.constFind(sysKey);
+
+	if (it != m_fileIcons.constEnd())
+		return it.value();
+
+	QPixmap pm = systemIcon(m_provider.icon(fi), FILE_ICON_SIZE);
+	m_fileIcons.insert(sysKey, pm);
+	return pm;
+}
+
+QPixmap IconCache::fileIcon(FileType::FileType type, const QFileInfo &fi)
+{
+	return fileIcon(fileIconKey(type, fi), fi);
+}
+
+QPixmap IconCache::directoryIcon(const QFileInfo &fi)
+{
+	const Logo &l = logo(fi.absoluteFilePath());
+
+	if (!l.pixmap.isNull())
+		return l.pixmap;
+
+	QString key = systemIconKey(QString("/%1").arg(DIRECTORY_ICON_SIZE));
+	auto it = m_fileIcons.constFind(key);
+
+	if (it != m_fileIcons.constEnd())
+		return it.value();
+
+	QPixmap pm = systemIcon(m_provider.icon(QFileIconProvider::Folder), DIRECTORY_ICON_SIZE);
+	m_fileIcons.insert(key, pm);
+	return pm;
+}
+
+QPixmap IconCache::textLogo(const QString &dir)
+{
+	return logo(dir).textPixmap;
+}
+
+void IconCache::invalidateLogo(const QString &dir)
+{
+	auto it = m_logos.find(dir);
+
+	if (it == m_logos.end())
+		return;
+
+	QString base = dir + "/" + METADATA_DIR + "/";
+
+	if (modified(base + LOGO_FILE) != it->modified
+			|| modified(base + LOGO_TEXT_FILE) != it->textModified)
+		m_logos.erase(it);
+}
+
+void IconCache::clearLogos()
+{
+	m_logos.clear();
+}
+
+IconCache::IconCache()
+{
+	connect(MetadataCache::get(), SIGNAL(cleared()), this, SLOT(clearLogos()));
+}
+
+const IconCache::Logo &IconCache::logo(const QString &dir)
+{
+	auto it = m_logos.constFind(dir);
+
+	if (it != m_logos.constEnd())
+		return it.value();
+
+	QString base = dir + "/" + METADATA_DIR + "/";
+	Logo l;
+
+	l.modified = modified(base + LOGO_FILE);
+	l.textModified = modified(base + LOGO_TEXT_FILE);
+
+	if (l.textModified.isValid())
+		l.textPixmap = QPixmap(base + LOGO_TEXT_FILE);
+
+	// LOGO_FILE takes precedence
+	if (l.modified.isValid())
+		l.pixmap = QPixmap(base + LOGO_FILE);
+	else
+		l.pixmap = l.textPixmap;
+
+	return m_logos.insert(dir, l).value();
+}
+
+QString IconCache::systemIconKey(const QString &key)
+{
+	// screens may differ in device pixel ratio
+	return key + "@" + QString::number(qApp->devicePixelRatio());
+}
+
+QPixmap IconCache::systemIcon(const QIcon &icon, int size)
+{
+	const qreal ratio = qApp->devicePixelRatio();
+	const int pixels = qRound(size * ratio);
+
+	QPixmap pm = icon.pixmap(pixels, pixels);
+	pm.setDevicePixelRatio(ratio);
+	return pm;
+}
+
+QDateTime IconCache::modified(const QString &path)
+{
+	QFileInfo fi(path);
+
+	return fi.exists() ? fi.lastModified() : QDateTime();
+}
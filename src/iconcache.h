@@ -0,0 +1,69 @@
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPixmap>
+#include <QDateTime>
+#include <QFileIconProvider>
+
+#include "file.h"
+
+/*!
+ * \brief Process-wide cache of icons used in models
+ *
+ * File icons are shared by all FileModel instances. They are keyed
+ * by fileIconKey(): builtin icons by FileType, system icons by suffix.
+ * System icons are rendered at the device pixel ratio of the application.
+ * Directory logos (LOGO_FILE, LOGO_TEXT_FILE) are cached by directory
+ * path together with the logo modification time.
+ */
+class IconCache : public QObject
+{
+	Q_OBJECT
+public:
+	static IconCache *get();
+
+	//! Load builtin icons of all file types
+	void warmUp();
+
+	QString fileIconKey(FileType::FileType type, const QFileInfo &fi);
+	QPixmap fileIcon(const QString &key, const QFileInfo &fi);
+	QPixmap fileIcon(FileType::FileType type, const QFileInfo &fi);
+
+	//! Logo of the directory or a system directory icon
+	QPixmap directoryIcon(const QFileInfo &fi);
+	//! Logo with text if available, null pixmap otherwise
+	QPixmap textLogo(const QString &dir);
+
+public slots:
+	//! Reload the logo of \a dir next time it is requested, if it has changed
+	void invalidateLogo(const QString &dir);
+	void clearLogos();
+
+private:
+	struct Logo {
+		//! Modification times of LOGO_FILE and LOGO_TEXT_FILE, invalid if missing
+		QDateTime modified;
+		QDateTime textModified;
+		QPixmap pixmap;
+		QPixmap textPixmap;
+	};
+
+	static IconCache *m_instance;
+	QFileIconProvider m_provider;
+	QHash<QString, QPixmap> m_fileIcons;
+	//! Builtin icon availability per FileType, filled by warmUp()
+	QVector<bool> m_builtin;
+	QHash<QString, Logo> m_logos;
+
+	IconCache();
+	const Logo &logo(const QString &dir);
+	static QDateTime modified(const QString &path);
+	//! Key of a system icon rendered for the current device pixel ratio
+	static QString systemIconKey(const QString &key);
+	//! System icon of \a size logical pixels at the device pixel ratio
+	static QPixmap systemIcon(const QIcon &icon, int size);
+};
+
+#endif // ICONCACHE_H
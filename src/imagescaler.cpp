@@ -0,0 +1,401 @@
+#include "imagescaler.h"
+
+#include <QVector>
+#include <QImageReader>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGESCALER_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is not baseline, it's compiled per function and selected at runtime
+#if defined(IMAGESCALER_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGESCALER_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IMAGESCALER_NEON
+#include <arm_neon.h>
+#endif
+
+// Weights of one destination pixel sum up to 1 << WEIGHT_BITS
+#define WEIGHT_BITS 14
+// Fraction bits of the vertically averaged row, keeps it within qint16
+#define ROW_BITS 7
+
+
+/*!
+ * Source pixels covering destination pixels along one axis.
+ */
+struct Coverage
+{
+	//! first source pixel of each destination pixel
+	QVector<int> first;
+	//! number of source pixels of each destination pixel
+	QVector<int> count;
+	//! offset of the first weight in weights
+	QVector<int> offset;
+	QVector<qint16> weights;
+
+	Coverage(int src, int dst)
+	{
+		first.resize(dst);
+		count.resize(dst);
+		offset.resize(dst);
+		weights.reserve(dst * (src / dst + 2));
+
+		// Source pixel j spans [j*dst, (j+1)*dst), destination pixel i
+		// spans [i*src, (i+1)*src), so the overlaps are exact integers.
+		// Weights are differences of rounded cumulative coverage, so they
+		// always sum up to exactly 1 << WEIGHT_BITS.
+		for (int i = 0; i < dst; i++)
+		{
+			const qint64 from = qint64(i) * src;
+			const qint64 to = from + src;
+			const int j0 = from / dst;
+			const int j1 = qMin<qint64>((to + dst - 1) / dst, src);
+
+			first[i] = j0;
+			count[i] = j1 - j0;
+			offset[i] = weights.count();
+
+			int prev = 0;
+
+			for (int j = j0; j < j1; j++)
+			{
+				const qint64 end = qMin<qint64>(qint64(j + 1) * dst, to) - from;
+				const int cum = (end * (1 << WEIGHT_BITS) + src / 2) / src;
+
+				weights << qint16(cum - prev);
+				prev = cum;
+			}
+		}
+	}
+};
+
+
+static void accumulateScalar(const uchar *row, int bytes, qint16 weight, qint32 *acc)
+{
+	for (int i = 0; i < bytes; i++)
+		acc[i] += row[i] * weight;
+}
+
+#ifdef IMAGESCALER_SSE2
+/*!
+ * Two rows at once: their bytes are interleaved to 16 bit pairs and
+ * multiplied by the pair of weights with pmaddwd.
+ */
+static void accumulatePairSSE2(const uchar *row0, const uchar *row1, int bytes,
+							   qint16 w0, qint16 w1, qint32 *acc)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w = _mm_set1_epi32((quint16(w1) << 16) | quint16(w0));
+	int i = 0;
+
+	for (; i + 16 <= bytes; i += 16)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+
+		__m128i alo = _mm_unpacklo_epi8(a, zero);
+		__m128i ahi = _mm_unpackhi_epi8(a, zero);
+		__m128i blo = _mm_unpacklo_epi8(b, zero);
+		__m128i bhi = _mm_unpackhi_epi8(b, zero);
+
+		__m128i *out = reinterpret_cast<__m128i*>(acc + i);
+
+		_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out),
+											_mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), w)));
+		_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1),
+												_mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), w)));
+		_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2),
+												_mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), w)));
+		_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3),
+												_mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), w)));
+	}
+
+	for (; i < bytes; i++)
+		acc[i] += row0[i] * w0 + row1[i] * w1;
+}
+#endif
+
+#ifdef IMAGESCALER_AVX2
+__attribute__((target("avx2")))
+static void accumulateAVX2(const uchar *row, int bytes, qint16 weight, qint32 *acc)
+{
+	const __m256i w = _mm256_set1_epi32(weight);
+	int i = 0;
+
+	for (; i + 16 <= bytes; i += 16)
+	{
+		__m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+		__m256i lo = _mm256_cvtepu8_epi32(px);
+		__m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(px, 8));
+
+		__m256i *out = reinterpret_cast<__m256i*>(acc + i);
+
+		_mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out),
+												  _mm256_mullo_epi32(lo, w)));
+		_mm256_storeu_si256(out + 1, _mm256_add_epi32(_mm256_loadu_si256(out + 1),
+													  _mm256_mullo_epi32(hi, w)));
+	}
+
+	for (; i < bytes; i++)
+		acc[i] += row[i] * weight;
+}
+#endif
+
+#ifdef IMAGESCALER_NEON
+static void accumulateNEON(const uchar *row, int bytes, qint16 weight, qint32 *acc)
+{
+	const uint16_t w = weight;
+	uint32_t *out = reinterpret_cast<uint32_t*>(acc);
+	int i = 0;
+
+	// all the values are positive, unsigned arithmetic gives the same bits
+	for (; i + 16 <= bytes; i += 16)
+	{
+		uint8x16_t px = vld1q_u8(row + i);
+		uint16x8_t lo = vmovl_u8(vget_low_u8(px));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(px));
+
+		vst1q_u32(out + i, vmlal_n_u16(vld1q_u32(out + i), vget_low_u16(lo), w));
+		vst1q_u32(out + i + 4, vmlal_n_u16(vld1q_u32(out + i + 4), vget_high_u16(lo), w));
+		vst1q_u32(out + i + 8, vmlal_n_u16(vld1q_u32(out + i + 8), vget_low_u16(hi), w));
+		vst1q_u32(out + i + 12, vmlal_n_u16(vld1q_u32(out + i + 12), vget_high_u16(hi), w));
+	}
+
+	for (; i < bytes; i++)
+		acc[i] += row[i] * weight;
+}
+#endif
+
+/*!
+ * Weighted sum of the source rows of one destination row into \a acc.
+ */
+static void accumulateRows(const QImage &src, const Coverage &rows, int y,
+						   ImageScaler::Kernel kernel, qint32 *acc)
+{
+	const int bytes = src.width() * 4;
+	const int cnt = rows.count[y];
+	const qint16 *w = rows.weights.constData() + rows.offset[y];
+	const int first = rows.first[y];
+
+	memset(acc, 0, bytes * sizeof(qint32));
+
+	switch (kernel)
+	{
+#ifdef IMAGESCALER_SSE2
+	case ImageScaler::SSE2:
+	{
+		int i = 0;
+
+		for (; i + 1 < cnt; i += 2)
+			accumulatePairSSE2(src.constScanLine(first + i), src.constScanLine(first + i + 1),
+							   bytes, w[i], w[i+1], acc);
+
+		if (i < cnt)
+			accumulatePairSSE2(src.constScanLine(first + i), src.constScanLine(first + i),
+							   bytes, w[i], 0, acc);
+		return;
+	}
+#endif
+
+#ifdef IMAGESCALER_AVX2
+	case ImageScaler::AVX2:
+		for (int i = 0; i < cnt; i++)
+			accumulateAVX2(src.constScanLine(first + i), bytes, w[i], acc);
+		return;
+#endif
+
+#ifdef IMAGESCALER_NEON
+	case ImageScaler::NEON:
+		for (int i = 0; i < cnt; i++)
+			accumulateNEON(src.constScanLine(first + i), bytes, w[i], acc);
+		return;
+#endif
+
+	default:
+		for (int i = 0; i < cnt; i++)
+			accumulateScalar(src.constScanLine(first + i), bytes, w[i], acc);
+		return;
+	}
+}
+
+/*!
+ * Horizontal pass over the vertically averaged row. It touches only
+ * destination height x source width values, so it's not vectorized.
+ */
+static void averageColumns(const qint16 *row, const Coverage &cols, uchar *dst)
+{
+	const int round = 1 << (WEIGHT_BITS + ROW_BITS - 1);
+	const int cnt = cols.first.count();
+
+	for (int x = 0; x < cnt; x++)
+	{
+		const qint16 *px = row + cols.first[x] * 4;
+		const qint16 *w = cols.weights.constData() + cols.offset[x];
+		const int n = cols.count[x];
+		qint32 c0 = round, c1 = round, c2 = round, c3 = round;
+
+		for (int i = 0; i < n; i++, px += 4)
+		{
+			c0 += px[0] * w[i];
+			c1 += px[1] * w[i];
+			c2 += px[2] * w[i];
+			c3 += px[3] * w[i];
+		}
+
+		*dst++ = c0 >> (WEIGHT_BITS + ROW_BITS);
+		*dst++ = c1 >> (WEIGHT_BITS + ROW_BITS);
+		*dst++ = c2 >> (WEIGHT_BITS + ROW_BITS);
+		*dst++ = c3 >> (WEIGHT_BITS + ROW_BITS);
+	}
+}
+
+QImage ImageScaler::scaled(const QImage &img, int width, int height, Kernel kernel)
+{
+	if (img.isNull() || width <= 0 || height <= 0)
+		return QImage();
+
+	if (width > img.width() || height > img.height())
+		return img.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+	if (kernel == Auto || !isSupported(kernel))
+		kernel = bestKernel();
+
+	QImage src = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+	QImage dst(width, height, QImage::Format_ARGB32_Premultiplied);
+
+	const Coverage rows(src.height(), height);
+	const Coverage cols(src.width(), width);
+	const int bytes = src.width() * 4;
+	const int rowRound = 1 << (WEIGHT_BITS - ROW_BITS - 1);
+
+	QVector<qint32> acc(bytes);
+	QVector<qint16> averaged(bytes);
+
+	for (int y = 0; y < height; y++)
+	{
+		accumulateRows(src, rows, y, kernel, acc.data());
+
+		// at most 255 << ROW_BITS, fits into qint16
+		for (int i = 0; i < bytes; i++)
+			averaged[i] = (acc[i] + rowRound) >> (WEIGHT_BITS - ROW_BITS);
+
+		averageColumns(averaged.constData(), cols, dst.scanLine(y));
+	}
+
+	dst.setDotsPerMeterX(img.dotsPerMeterX());
+	dst.setDotsPerMeterY(img.dotsPerMeterY());
+
+	return dst;
+}
+
+QImage ImageScaler::scaledToFit(const QImage &img, const QSize &size, Kernel kernel)
+{
+	if (img.isNull())
+		return QImage();
+
+	QSize s = img.size();
+	s.scale(size, Qt::KeepAspectRatio);
+
+	return scaled(img, qMax(s.width(), 1), qMax(s.height(), 1), kernel);
+}
+
+QImage ImageScaler::readToFit(QImageReader &reader, const QSize &size)
+{
+	const QSize full = reader.size();
+
+	// Only JPEG is really scaled while decoding, by 1/2, 1/4 or 1/8 in the DCT.
+	// Other handlers decode the full image and scale it smoothly.
+	if (full.isValid() && reader.format() == "jpeg")
+	{
+		const QSize fit = full.scaled(size, Qt::KeepAspectRatio);
+
+		for (int factor = 8; factor > 1; factor /= 2)
+		{
+			const QSize decoded((full.width() + factor - 1) / factor, (full.height() + factor - 1) / factor);
+
+			if (decoded.width() >= fit.width() && decoded.height() >= fit.height())
+			{
+				reader.setScaledSize(decoded);
+				break;
+			}
+		}
+	}
+
+	QImage img = reader.read();
+
+	if (img.isNull())
+		return img;
+
+	// already fitted: within the size and touching it on one side
+	if (img.width() <= size.width() && img.height() <= size.height()
+			&& (img.width() == size.width() || img.height() == size.height()))
+		return img;
+
+	return scaledToFit(img, size);
+}
+
+bool ImageScaler::isSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+	case Auto:
+	case Scalar:
+		return true;
+
+#ifdef IMAGESCALER_SSE2
+	case SSE2:
+		return true;
+#endif
+
+#ifdef IMAGESCALER_AVX2
+	case AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+
+#ifdef IMAGESCALER_NEON
+	case NEON:
+		return true;
+#endif
+
+	default:
+		return false;
+	}
+}
+
+ImageScaler::Kernel ImageScaler::bestKernel()
+{
+	static const Kernel order[] = { AVX2, SSE2, NEON };
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (isSupported(order[i]))
+			return order[i];
+	}
+
+	return Scalar;
+}
+
+QString ImageScaler::kernelName(Kernel kernel)
+{
+	switch (kernel)
+	{
+	case Auto:
+		return "auto";
+	case Scalar:
+		return "scalar";
+	case SSE2:
+		return "sse2";
+	case AVX2:
+		return "avx2";
+	case NEON:
+		return "neon";
+	default:
+		return QString();
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef IMAGESCALER_H
+#define IMAGESCALER_H
+
+#include <QImage>
+#include <QString>
+
+class QImageReader;
+
+/*!
+ * \brief Area averaging image downscaler
+ *
+ * Every destination pixel is the average of the source area it covers,
+ * weighted by the covered fraction of the edge pixels. Unlike the fast
+ * (nearest neighbour) transformation it does not drop the thin lines of
+ * CAD drawings, and it's much cheaper than the smooth transformation
+ * for large reduction factors.
+ *
+ * Images are scaled as ARGB32 premultiplied. The vertical pass, which
+ * touches every source pixel, has SSE2, AVX2 and NEON kernels. All
+ * kernels use the same fixed point arithmetic, so their results are
+ * identical.
+ *
+ * Enlarging is left to QImage::scaled() with smooth transformation.
+ */
+class ImageScaler
+{
+public:
+	enum Kernel {
+		Auto = 0,
+		Scalar,
+		SSE2,
+		AVX2,
+		NEON,
+		KernelCount
+	};
+
+	//! Scale \a img to exactly \a width x \a height
+	static QImage scaled(const QImage &img, int width, int height, Kernel kernel = Auto);
+	//! Scale \a img to fit into \a size keeping the aspect ratio
+	static QImage scaledToFit(const QImage &img, const QSize &size, Kernel kernel = Auto);
+	//! Read the image of \a reader downscaled to fit into \a size
+	static QImage readToFit(QImageReader &reader, const QSize &size);
+
+	//! The kernel is compiled in and supported by the CPU
+	static bool isSupported(Kernel kernel);
+	//! The fastest supported kernel
+	static Kernel bestKernel();
+	static QString kernelName(Kernel kernel);
+};
+
+#endif // IMAGESCALER_H
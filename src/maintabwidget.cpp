@@ -2,6 +2,7 @@
 #include "ui_maintabwidget.h"
 #include "datasourcewidget.h"
 #include "settings.h"
+#include "iconcache.h"
 
 #include <QDebug>
 #include <QPushButton>
@@ -157,10 +158,10 @@ void MainTabWidget::updateTabTitle(DataSourceWidget *dsw, const QString &dir)
 {
 	int i = indexOf(dsw);
 	QString label = MetadataCache::get()->label(dir);
-	QString logoPath = dir + "/" + METADATA_DIR + "/";
+	QPixmap logo = IconCache::get()->textLogo(dir);
 
-	if (QFile::exists(logoPath + LOGO_TEXT_FILE))
-		setTabIcon(i, QIcon(logoPath + LOGO_TEXT_FILE));
+	if (!logo.isNull())
+		setTabIcon(i, QIcon(logo));
 
 	setTabText(
 		i,
@@ -26,6 +26,7 @@
 
 #include "metadata.h"
 #include "settings.h"
+#include "partcache.h"
 #include "metadata/metadatamigrator.h"
 
 
@@ -159,7 +160,7 @@ QString MetadataCache::partParam(const QString &path, const QString &fname, int
 
 MetadataVersionsMap MetadataCache::partVersions(const QString &path)
 {
-	return get(path)->partVersions();
+	return PartCache::get()->versionIndex(path).versionsMap();
 }
 
 void MetadataCache::deletePart(const QString &path, const QString &part)
@@ -226,7 +227,6 @@ Metadata::~Metadata()
 	delete m_settings;
 
 	m_parameterLabels.clear();
-	m_versionsCache.clear();
 }
 
 QString Metadata::getLabel()
@@ -472,18 +472,6 @@ void Metadata::setPartParam(const QString &partName, const QString &param, const
 	m_settings->endGroup();
 }
 
-bool Metadata::partVersionType(FileType::FileType t, const QFileInfo &fi)
-{
-	QRegExp re(File::getRxForFileType(t));
-	re.setCaseSensitivity(Qt::CaseInsensitive);
-	if (re.exactMatch(fi.fileName()))
-	{
-		m_versionsCache[fi.completeBaseName()] = fi.fileName();
-		return true;
-	}
-	return false;
-}
-
 void Metadata::rename(const QString &oldName, const QString &newName)
 {
 	QHash<QString, QVariant> settings;
@@ -533,30 +521,6 @@ QList<Metadata *> Metadata::includedMetadatas(QStringList paths)
 	return ret;
 }
 
-MetadataVersionsMap Metadata::partVersions()
-{
-	if (m_versionsCache.size())
-		return m_versionsCache;
-
-	QDir d(m_path);
-	QStringList files = d.entryList(QStringList(),
-	                                QDir::Files | QDir::Readable,
-	                                QDir::Name);
-
-	QFileInfo fi;
-	foreach (QString i, files)
-	{
-		fi.setFile(i);
-		foreach(FileType::FileType t, File::versionedTypes())
-		{
-			if (partVersionType(t, fi.fileName()))
-				break;
-		}
-	}
-
-	return m_versionsCache;
-}
-
 QList<Metadata *> Metadata::dataIncludes()
 {
 	return includedMetadatas(m_dataIncludes);
@@ -88,11 +88,6 @@ public:
 	void setPartParam(const QString &partName, const QString &param, const QString &value);
 
 	void deletePart(const QString &part);
-	/*! Load part versions.
-	 * Implementation: list name-ordered directory and use only the latest
-	 * file name for its completeBaseName
-	 */
-	MetadataVersionsMap partVersions();
 
 	QList<Metadata*> dataIncludes();
 	QList<Metadata*> thumbnailIncludes();
@@ -110,14 +105,11 @@ private:
 	QStringList m_parameterLabels;
 	QString label;
 
-	MetadataVersionsMap m_versionsCache;
-
 	void setup();
 	int version();
 	bool isEmpty();
 	QString buildIncludePath(const QString &raw);
 	QStringList buildIncludePaths(const QStringList &raw);
-	bool partVersionType(FileType::FileType t, const QFileInfo &fi);
 	void rename(const QString &oldName, const QString &newName);
 	void recursiveRename(const QString &path, QHash<QString, QVariant> &settings);
 	QList<Metadata*> includedMetadatas(QStringList paths);
@@ -142,6 +134,7 @@ public:
 	QStringList parameterLabels(const QString &path);
 	QString partParam(const QString &path, const QString &fname, const QString &param);
 	QString partParam(const QString &path, const QString &fname, int index);
+	//! Latest part versions, see PartVersionIndex
 	MetadataVersionsMap partVersions(const QString &path);
 	void deletePart(const QString &path, const QString &part);
     Metadata* metadata(const QString &path);
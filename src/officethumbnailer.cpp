@@ -0,0 +1,47 @@
+#include "officethumbnailer.h"
+#include "zipreader.h"
+#include "imagescaler.h"
+
+// Larger entries are not previews, they are not read at all
+#define OFFICE_MAX_PREVIEW_SIZE (16 * 1024 * 1024)
+
+
+QStringList OfficeThumbnailer::nameFilters() const
+{
+	return QStringList()
+		// OpenDocument
+		<< "*.odt" << "*.ott" << "*.odm" << "*.ods" << "*.ots"
+		<< "*.odp" << "*.otp" << "*.odg" << "*.otg" << "*.odb"
+		// Office Open XML
+		<< "*.docx" << "*.docm" << "*.dotx" << "*.dotm"
+		<< "*.xlsx" << "*.xlsm" << "*.xltx" << "*.xltm"
+		<< "*.pptx" << "*.pptm" << "*.potx" << "*.potm" << "*.ppsx" << "*.ppsm";
+}
+
+QImage OfficeThumbnailer::render(const QFileInfo &fi, int size, int budgetMs) const
+{
+	Q_UNUSED(budgetMs);
+
+	ZipReader zip(fi.absoluteFilePath());
+
+	if (!zip.isValid())
+		return QImage();
+
+	int entry = zip.find("Thumbnails/thumbnail.png");
+
+	if (entry == -1)
+		entry = zip.findPrefix("docProps/thumbnail.");
+
+	if (entry == -1)
+		return QImage();
+
+	QImage img = QImage::fromData(zip.read(entry, OFFICE_MAX_PREVIEW_SIZE));
+
+	if (img.isNull())
+		return QImage();
+
+	if (img.width() > size || img.height() > size)
+		return ImageScaler::scaledToFit(img, QSize(size, size));
+
+	return img;
+}
@@ -0,0 +1,21 @@
+#ifndef OFFICETHUMBNAILER_H
+#define OFFICETHUMBNAILER_H
+
+#include "thumbnailer.h"
+
+/*!
+ * \brief Previews embedded in OpenDocument and Office Open XML files
+ *
+ * Both are ZIP archives. OpenDocument stores the preview in
+ * Thumbnails/thumbnail.png, Office Open XML in docProps/thumbnail.*
+ * when saving with a preview is enabled. Metafile previews
+ * of Office Open XML are not supported.
+ */
+class OfficeThumbnailer : public AbstractThumbnailer
+{
+public:
+	QStringList nameFilters() const;
+	QImage render(const QFileInfo &fi, int size, int budgetMs) const;
+};
+
+#endif // OFFICETHUMBNAILER_H
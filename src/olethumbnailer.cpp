@@ -0,0 +1,164 @@
+#include <QtEndian>
+#include <QDataStream>
+
+#include "olethumbnailer.h"
+#include "compounddocument.h"
+#include "imagescaler.h"
+
+// Larger streams are not previews, they are not read at all
+#define OLE_MAX_PREVIEW_SIZE (16 * 1024 * 1024)
+// Property of the summary information holding the thumbnail
+#define OLE_PIDSI_THUMBNAIL 17
+#define OLE_VT_CF 0x47
+// Windows clipboard formats
+#define OLE_CF_DIB 8
+#define OLE_CF_BITMAP 2
+
+
+static quint32 le32(const QByteArray &data, int offset)
+{
+	return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data.constData() + offset));
+}
+
+
+QStringList OleThumbnailer::nameFilters() const
+{
+	return QStringList()
+		<< "*.sldprt" << "*.sldasm" << "*.slddrw"
+		<< "*.ipt" << "*.iam" << "*.idw"
+		<< "*.par" << "*.psm" << "*.dft";
+}
+
+QImage OleThumbnailer::render(const QFileInfo &fi, int size, int budgetMs) const
+{
+	Q_UNUSED(budgetMs);
+
+	// SolidWorks 2015 and newer do not use OLE2 anymore
+	CompoundDocument doc(fi.absoluteFilePath());
+
+	if (!doc.isValid())
+		return QImage();
+
+	QImage img = previewStream(doc);
+
+	if (img.isNull())
+		img = summaryThumbnail(doc);
+
+	if (img.isNull())
+		return QImage();
+
+	if (img.width() > size || img.height() > size)
+		return ImageScaler::scaledToFit(img, QSize(size, size));
+
+	return img;
+}
+
+QImage OleThumbnailer::previewStream(CompoundDocument &doc) const
+{
+	// SolidWorks stores PNG since 2008, DIB in older versions
+	static const char * const names[] = { "PreviewPNG", "Preview", "Thumbnail", 0 };
+
+	for (int i = 0; names[i]; i++)
+	{
+		const int entry = doc.find(names[i]);
+
+		if (entry == -1)
+			continue;
+
+		QImage img = decode(doc.stream(entry, OLE_MAX_PREVIEW_SIZE));
+
+		if (!img.isNull())
+			return img;
+	}
+
+	return QImage();
+}
+
+QImage OleThumbnailer::summaryThumbnail(CompoundDocument &doc) const
+{
+	const QByteArray data = doc.stream(doc.find(QString(QChar(5)) + "SummaryInformation"), OLE_MAX_PREVIEW_SIZE);
+
+	// property set header, the offset of the first section follows its FMTID
+	if (data.size() < 48 || le32(data, 24) < 1)
+		return QImage();
+
+	const quint32 section = le32(data, 44);
+
+	if (quint64(section) + 8 > quint64(data.size()))
+		return QImage();
+
+	const quint32 count = le32(data, section + 4);
+
+	for (quint32 i = 0; i < count; i++)
+	{
+		const quint64 pair = quint64(section) + 8 + i * 8;
+
+		if (pair + 8 > quint64(data.size()))
+			break;
+
+		if (le32(data, pair) != OLE_PIDSI_THUMBNAIL)
+			continue;
+
+		// VT_CF: type, size, clipboard format tag and format, then the data
+		const quint64 prop = quint64(section) + le32(data, pair + 4);
+
+		if (prop + 16 > quint64(data.size()) || le32(data, prop) != OLE_VT_CF)
+			return QImage();
+
+		const quint32 size = le32(data, prop + 4);
+		const qint32 tag = qint32(le32(data, prop + 8));
+		const quint32 format = le32(data, prop + 12);
+
+		if (size < 8 || prop + 8 + size > quint64(data.size()))
+			return QImage();
+
+		const QByteArray payload = data.mid(prop + 16, size - 8);
+
+		// -1 is a Windows clipboard format, metafiles are not supported
+		if (tag == -1 && format != OLE_CF_DIB && format != OLE_CF_BITMAP)
+			return QImage();
+
+		return decode(payload);
+	}
+
+	return QImage();
+}
+
+QImage OleThumbnailer::decode(const QByteArray &data) const
+{
+	if (data.size() < 40)
+		return QImage();
+
+	QImage img;
+
+	if (img.loadFromData(data))
+		return img;
+
+	// BITMAPINFOHEADER without BITMAPFILEHEADER, which has to be prepended
+	const quint32 headerSize = le32(data, 0);
+
+	if (headerSize < 40 || headerSize >= quint32(data.size()))
+		return QImage();
+
+	const quint16 bitCount = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(data.constData() + 14));
+	const quint32 compression = le32(data, 16);
+	quint32 colors = le32(data, 32);
+
+	if (colors == 0 && bitCount <= 8)
+		colors = 1 << bitCount;
+
+	// BI_BITFIELDS masks follow the short header
+	const quint32 masks = (compression == 3 && headerSize == 40) ? 12 : 0;
+
+	QByteArray bmp;
+	QDataStream s(&bmp, QIODevice::WriteOnly);
+	s.setByteOrder(QDataStream::LittleEndian);
+	s.writeRawData("BM", 2);
+	s << quint32(14 + data.size()) << quint32(0) << quint32(14 + headerSize + masks + colors * 4);
+	s.writeRawData(data.constData(), data.size());
+
+	if (img.loadFromData(bmp, "BMP"))
+		return img;
+
+	return QImage();
+}
@@ -0,0 +1,29 @@
+#ifndef OLETHUMBNAILER_H
+#define OLETHUMBNAILER_H
+
+#include "thumbnailer.h"
+
+class CompoundDocument;
+
+/*!
+ * \brief Previews embedded in OLE2 files of SolidWorks, Inventor and Solid Edge
+ *
+ * The CAD applications store a preview image when saving the file. It's
+ * either a stream of its own (PNG or DIB) or the thumbnail property of
+ * the summary information stream. Only the sectors of the preview are
+ * read, see CompoundDocument.
+ */
+class OleThumbnailer : public AbstractThumbnailer
+{
+public:
+	QStringList nameFilters() const;
+	QImage render(const QFileInfo &fi, int size, int budgetMs) const;
+
+private:
+	QImage previewStream(CompoundDocument &doc) const;
+	QImage summaryThumbnail(CompoundDocument &doc) const;
+	//! Decode PNG, JPEG or a device independent bitmap without file header
+	QImage decode(const QByteArray &data) const;
+};
+
+#endif // OLETHUMBNAILER_H
@@ -27,6 +27,7 @@ QFileInfoList PartCache::parts(const QString &dir)
 	);
 
 	m_parts.insert(dir, list);
+	m_versionIndexes.insert(dir, PartVersionIndex(list));
 	return list;
 }
 
@@ -40,12 +41,30 @@ QFileInfo PartCache::partAt(const QString &dir, int index)
 	return parts(dir).at(index);
 }
 
+const PartNameIndex &PartCache::nameIndex(const QString &dir)
+{
+	if (!m_nameIndexes.contains(dir))
+		m_nameIndexes.insert(dir, PartNameIndex(parts(dir)));
+
+	return m_nameIndexes[dir];
+}
+
+const PartVersionIndex &PartCache::versionIndex(const QString &dir)
+{
+	if (!m_versionIndexes.contains(dir))
+		parts(dir);
+
+	return m_versionIndexes[dir];
+}
+
 void PartCache::clear(const QString &dir)
 {
 	if (!m_parts.contains(dir))
 		return;
 
 	m_parts.remove(dir);
+	m_nameIndexes.remove(dir);
+	m_versionIndexes.remove(dir);
 	emit cleared(dir);
 }
 
@@ -54,8 +73,12 @@ void PartCache::renameDirectory(const QString &oldDir, const QString &newDir)
 	if (!m_parts.contains(oldDir))
 		return;
 
-	m_parts.insert(newDir, m_parts[oldDir]);
-	m_parts.remove(oldDir);
+	m_parts.insert(newDir, m_parts.take(oldDir));
+
+	if (m_nameIndexes.contains(oldDir))
+		m_nameIndexes.insert(newDir, m_nameIndexes.take(oldDir));
+
+	m_versionIndexes.insert(newDir, m_versionIndexes.take(oldDir));
 	emit directoryRenamed(oldDir, newDir);
 }
 
@@ -3,6 +3,10 @@
 
 #include <QObject>
 #include <QFileInfoList>
+#include <QHash>
+
+#include "partnameindex.h"
+#include "partversionindex.h"
 
 class PartCache : public QObject
 {
@@ -12,6 +16,10 @@ public:
 	QFileInfoList parts(const QString &dir);
 	int count(const QString &dir);
 	QFileInfo partAt(const QString &dir, int index);
+	//! Sorted name index of parts(), built on first use
+	const PartNameIndex &nameIndex(const QString &dir);
+	//! Pro/E versions of parts(), built together with the listing
+	const PartVersionIndex &versionIndex(const QString &dir);
 	void clear(const QString &dir);
 	void renameDirectory(const QString &oldDir, const QString &newDir);
 
@@ -22,6 +30,8 @@ signals:
 private:
 	static PartCache *m_instance;
 	QHash<QString, QFileInfoList> m_parts;
+	QHash<QString, PartNameIndex> m_nameIndexes;
+	QHash<QString, PartVersionIndex> m_versionIndexes;
 
 	PartCache();
 
@@ -0,0 +1,157 @@
+#include <QHash>
+#include <algorithm>
+
+#include "partnameindex.h"
+#include "columnmatcher.h"
+
+
+PartNameIndex::PartNameIndex()
+{
+}
+
+PartNameIndex::PartNameIndex(const QFileInfoList &parts)
+{
+	const int cnt = parts.count();
+	QHash<QString, int> groups;
+
+	m_entries.reserve(cnt);
+	m_groups.reserve(cnt);
+
+	for (int row = 0; row < cnt; row++)
+	{
+		const QFileInfo &fi = parts[row];
+		QString base = ColumnMatcher::fold(fi.baseName());
+
+		Entry e;
+		e.key = ColumnMatcher::fold(fi.fileName());
+		e.row = row;
+		m_entries << e;
+
+		int g = groups.value(base, -1);
+
+		if (g == -1)
+		{
+			g = groups.count();
+			groups.insert(base, g);
+		}
+
+		m_groups << g;
+	}
+
+	std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+		return a.key < b.key;
+	});
+
+	// counting sort of rows by group
+	const int groupCnt = groups.count();
+	m_groupOffsets.fill(0, groupCnt + 1);
+
+	foreach (int g, m_groups)
+		m_groupOffsets[g+1]++;
+
+	for (int g = 0; g < groupCnt; g++)
+		m_groupOffsets[g+1] += m_groupOffsets[g];
+
+	QVector<int> pos = m_groupOffsets;
+	m_groupEntries.resize(cnt);
+
+	for (int row = 0; row < cnt; row++)
+		m_groupEntries[pos[m_groups[row]]++] = row;
+}
+
+int PartNameIndex::count() const
+{
+	return m_entries.count();
+}
+
+QPair<int, int> PartNameIndex::prefixRange(const QString &prefix) const
+{
+	QString key = ColumnMatcher::fold(prefix);
+	int first = lowerBound(key);
+
+	// names with the prefix form a contiguous block starting at first
+	auto it = std::upper_bound(m_entries.constBegin() + first, m_entries.constEnd(), key,
+		[](const QString &k, const Entry &e) {
+			return k < e.key && !e.key.startsWith(k);
+		}
+	);
+
+	return qMakePair(first, int(it - m_entries.constBegin()));
+}
+
+int PartNameIndex::rowAt(int position) const
+{
+	return m_entries[position].row;
+}
+
+int PartNameIndex::find(const QString &name) const
+{
+	QString key = ColumnMatcher::fold(name);
+	int pos = lowerBound(key);
+
+	// exact file name
+	if (pos < m_entries.count() && m_entries[pos].key == key)
+		return m_entries[pos].row;
+
+	// "base name." prefix, e.g. "part-a.prt" sorts before "part.prt",
+	// so the block is looked up on its own
+	const QString base = key + ".";
+	const int cnt = m_entries.count();
+	int found = -1;
+	int foundVersion = -1;
+
+	for (pos = lowerBound(base); pos < cnt && m_entries[pos].key.startsWith(base); pos++)
+	{
+		// the latest Pro/E version, "part.prt.10" sorts before "part.prt.2"
+		const int v = version(m_entries[pos].key);
+
+		if (found == -1 || v > foundVersion)
+		{
+			found = m_entries[pos].row;
+			foundVersion = v;
+		}
+	}
+
+	return found;
+}
+
+int PartNameIndex::group(int row) const
+{
+	if (row < 0 || row >= m_groups.count())
+		return -1;
+
+	return m_groups[row];
+}
+
+QVector<int> PartNameIndex::groupRows(int group) const
+{
+	if (group < 0 || group + 1 >= m_groupOffsets.count())
+		return QVector<int>();
+
+	const int from = m_groupOffsets[group];
+	return m_groupEntries.mid(from, m_groupOffsets[group+1] - from);
+}
+
+int PartNameIndex::version(const QString &key)
+{
+	const int dot = key.lastIndexOf('.');
+
+	if (dot == -1)
+		return -1;
+
+	bool ok;
+	const int v = key.mid(dot + 1).toInt(&ok);
+
+	return ok ? v : -1;
+}
+
+int PartNameIndex::lowerBound(const QString &key) const
+{
+	auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), key,
+		[](const Entry &e, const QString &k) {
+			return e.key < k;
+		}
+	);
+
+	return it - m_entries.constBegin();
+}
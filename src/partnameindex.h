@@ -0,0 +1,58 @@
+#ifndef PARTNAMEINDEX_H
+#define PARTNAMEINDEX_H
+
+#include <QFileInfoList>
+#include <QVector>
+#include <QPair>
+
+/*!
+ * \brief Sorted index of part names of one directory
+ *
+ * Names are folded by ColumnMatcher::fold() and sorted, so that all
+ * parts starting with a prefix are found by a binary search. Parts are
+ * also grouped by their base name, i.e. all Pro/E versions
+ * and extensions of one part belong to the same group.
+ *
+ * Rows are indexes into PartCache::parts().
+ */
+class PartNameIndex
+{
+public:
+	PartNameIndex();
+	explicit PartNameIndex(const QFileInfoList &parts);
+
+	int count() const;
+
+	//! Range of sorted positions [first, last) of names starting with \a prefix
+	QPair<int, int> prefixRange(const QString &prefix) const;
+	//! Row at sorted position
+	int rowAt(int position) const;
+	//! Row of the part with file name or base name \a name, -1 if not found.
+	//! Of more Pro/E versions the latest one is returned.
+	int find(const QString &name) const;
+
+	//! Group (base name) id of a row
+	int group(int row) const;
+	//! All rows of a group
+	QVector<int> groupRows(int group) const;
+
+private:
+	struct Entry {
+		QString key;
+		int row;
+	};
+
+	QVector<Entry> m_entries;
+	//! row -> group id
+	QVector<int> m_groups;
+	//! group id -> first sorted position of the group in m_groupEntries
+	QVector<int> m_groupOffsets;
+	//! rows ordered by group
+	QVector<int> m_groupEntries;
+
+	int lowerBound(const QString &key) const;
+	//! Numeric last extension of \a key, -1 when there is none
+	static int version(const QString &key);
+};
+
+#endif // PARTNAMEINDEX_H
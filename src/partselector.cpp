@@ -12,33 +12,83 @@ PartSelector *PartSelector::get()
 
 void PartSelector::select(const QString &dir, const QString &partPath)
 {
-	if (m_selected.contains(dir))
-		m_selected[dir] << partPath;
-	else
-		m_selected.insert(dir, QStringList() << partPath);
+	m_selected[dir].insert(partPath);
+}
+
+void PartSelector::select(const QString &dir, const QStringList &partPaths)
+{
+	if (partPaths.isEmpty())
+		return;
+
+	PartSet &parts = m_selected[dir];
+	parts.reserve(parts.size() + partPaths.size());
+
+	foreach (const QString &path, partPaths)
+		parts.insert(path);
+
+	emit selectionChanged(dir);
 }
 
 bool PartSelector::isSelected(const QString &dir, const QString &partPath) const
 {
-	if (!m_selected.contains(dir))
+	auto it = m_selected.constFind(dir);
+
+	if (it == m_selected.constEnd())
 		return false;
 
-	return m_selected.value(dir).contains(partPath);
+	return it.value().contains(partPath);
+}
+
+int PartSelector::selectedCount(const QString &dir) const
+{
+	auto it = m_selected.constFind(dir);
+
+	return it == m_selected.constEnd() ? 0 : it.value().size();
 }
 
 void PartSelector::clear()
 {
+	QList<QString> dirs = m_selected.keys();
+
 	m_selected.clear();
+
+	foreach (const QString &dir, dirs)
+		emit selectionChanged(dir);
 }
 
 void PartSelector::clear(const QString &dir)
 {
-	m_selected.remove(dir);
+	if (m_selected.remove(dir))
+		emit selectionChanged(dir);
 }
 
 void PartSelector::clear(const QString &dir, const QString &partPath)
 {
-	m_selected[dir].removeOne(partPath);
+	auto it = m_selected.find(dir);
+
+	if (it == m_selected.end())
+		return;
+
+	it.value().remove(partPath);
+
+	if (it.value().isEmpty())
+		m_selected.erase(it);
+}
+
+void PartSelector::clear(const QString &dir, const QStringList &partPaths)
+{
+	auto it = m_selected.find(dir);
+
+	if (it == m_selected.end())
+		return;
+
+	foreach (const QString &path, partPaths)
+		it.value().remove(path);
+
+	if (it.value().isEmpty())
+		m_selected.erase(it);
+
+	emit selectionChanged(dir);
 }
 
 void PartSelector::toggle(const QString &dir, const QString &partPath)
@@ -49,6 +99,25 @@ void PartSelector::toggle(const QString &dir, const QString &partPath)
 		select(dir, partPath);
 }
 
+void PartSelector::invert(const QString &dir, const QStringList &partPaths)
+{
+	if (partPaths.isEmpty())
+		return;
+
+	PartSet &parts = m_selected[dir];
+
+	foreach (const QString &path, partPaths)
+	{
+		if (!parts.remove(path))
+			parts.insert(path);
+	}
+
+	if (parts.isEmpty())
+		m_selected.remove(dir);
+
+	emit selectionChanged(dir);
+}
+
 QStringList PartSelector::allSelected() const
 {
 	QStringList ret;
@@ -57,15 +126,17 @@ QStringList PartSelector::allSelected() const
 	while (it.hasNext())
 	{
 		it.next();
-		ret << it.value();
+
+		foreach (const QString &path, it.value())
+			ret << path;
 	}
 
 	return ret;
 }
 
-QHashIterator<QString, QStringList> PartSelector::allSelectedIterator() const
+PartSelector::Iterator PartSelector::allSelectedIterator() const
 {
-	return QHashIterator<QString, QStringList>(m_selected);
+	return Iterator(m_selected);
 }
 
 PartSelector::PartSelector() : QObject()
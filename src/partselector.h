@@ -3,25 +3,50 @@
 
 #include <QObject>
 #include <QHash>
+#include <QSet>
+#include <QStringList>
 
+/*!
+ * \brief Checked parts of all directories
+ *
+ * Parts are stored in a hash set per directory, so membership tests
+ * done on every repaint of the check boxes are O(1). Part paths are
+ * implicitly shared with FileModel rows, so the sets do not copy them.
+ *
+ * Bulk operations emit selectionChanged() once per call, single part
+ * changes are reported by the model itself.
+ */
 class PartSelector : public QObject
 {
 	Q_OBJECT
 
 public:
+	typedef QSet<QString> PartSet;
+	typedef QHashIterator<QString, PartSet> Iterator;
+
 	static PartSelector *get();
 	void select(const QString &dir, const QString &partPath);
+	//! Select all \a partPaths at once
+	void select(const QString &dir, const QStringList &partPaths);
 	bool isSelected(const QString &dir, const QString &partPath) const;
+	int selectedCount(const QString &dir) const;
 	void clear();
 	void clear(const QString &dir);
 	void clear(const QString &dir, const QString &partPath);
+	void clear(const QString &dir, const QStringList &partPaths);
 	void toggle(const QString &dir, const QString &partPath);
+	//! Toggle all \a partPaths
+	void invert(const QString &dir, const QStringList &partPaths);
 	QStringList allSelected() const;
-	QHashIterator<QString, QStringList> allSelectedIterator() const;
+	Iterator allSelectedIterator() const;
+
+signals:
+	//! Emitted by bulk operations and clear() of a whole directory
+	void selectionChanged(const QString &dir);
 
 private:
 	static PartSelector *m_instance;
-	QHash<QString, QStringList> m_selected;
+	QHash<QString, PartSet> m_selected;
 
 	PartSelector();
 };
@@ -0,0 +1,116 @@
+#include <QRegularExpression>
+#include <algorithm>
+
+#include "partversionindex.h"
+
+
+//! Matches file names of all versioned types, e.g. part.prt.1
+static QRegularExpression versionRx()
+{
+	QStringList exts;
+
+	foreach (FileType::FileType t, File::versionedTypes())
+		exts << QRegularExpression::escape(File::getLabelForFileType(t).mid(2));
+
+	QRegularExpression rx(
+		"^(.+\\.(?:" + exts.join('|') + "))\\.(\\d+)$",
+		QRegularExpression::CaseInsensitiveOption
+	);
+	rx.optimize();
+
+	return rx;
+}
+
+
+PartVersionIndex::PartVersionIndex()
+{
+}
+
+PartVersionIndex::PartVersionIndex(const QFileInfoList &parts)
+{
+	static const QRegularExpression rx = versionRx();
+
+	const int cnt = parts.count();
+	m_partOf.fill(-1, cnt);
+	m_versions.fill(-1, cnt);
+
+	for (int row = 0; row < cnt; row++)
+	{
+		const QFileInfo &fi = parts[row];
+		QRegularExpressionMatch m = rx.match(fi.fileName());
+
+		if (!m.hasMatch() || fi.isDir())
+			continue;
+
+		QString name = m.captured(1);
+		int id = m_names.value(name, -1);
+
+		if (id == -1)
+		{
+			id = m_parts.count();
+			m_names.insert(name, id);
+			m_parts << QVector<int>();
+		}
+
+		m_partOf[row] = id;
+		m_versions[row] = m.captured(2).toInt();
+		m_parts[id] << row;
+	}
+
+	QHashIterator<QString, int> it(m_names);
+
+	while (it.hasNext())
+	{
+		it.next();
+
+		QVector<int> &rows = m_parts[it.value()];
+		std::sort(rows.begin(), rows.end(), [this](int a, int b) {
+			return m_versions[a] > m_versions[b];
+		});
+
+		m_latest.insert(it.key(), parts[rows.first()].fileName());
+	}
+}
+
+bool PartVersionIndex::isVersioned(int row) const
+{
+	return row >= 0 && row < m_partOf.count() && m_partOf[row] != -1;
+}
+
+bool PartVersionIndex::isLatest(int row) const
+{
+	return !isVersioned(row) || m_parts[m_partOf[row]].first() == row;
+}
+
+int PartVersionIndex::version(int row) const
+{
+	return isVersioned(row) ? m_versions[row] : -1;
+}
+
+int PartVersionIndex::latestRow(int row) const
+{
+	return isVersioned(row) ? m_parts[m_partOf[row]].first() : row;
+}
+
+QVector<int> PartVersionIndex::versionRows(int row) const
+{
+	if (!isVersioned(row))
+		return QVector<int>() << row;
+
+	return m_parts[m_partOf[row]];
+}
+
+QVector<int> PartVersionIndex::versionRows(const QString &completeBaseName) const
+{
+	int id = m_names.value(completeBaseName, -1);
+
+	if (id == -1)
+		return QVector<int>();
+
+	return m_parts[id];
+}
+
+MetadataVersionsMap PartVersionIndex::versionsMap() const
+{
+	return m_latest;
+}
@@ -0,0 +1,49 @@
+#ifndef PARTVERSIONINDEX_H
+#define PARTVERSIONINDEX_H
+
+#include <QFileInfoList>
+#include <QVector>
+#include <QHash>
+
+#include "metadata.h"
+
+/*!
+ * \brief Pro/E version index of one directory
+ *
+ * Pro/E stores every saved version of a part as a separate file,
+ * e.g. part.prt.1, part.prt.2, ..., part.prt.10. The index groups these
+ * files by completeBaseName (part.prt) and sorts them by the numeric
+ * version, so part.prt.10 is newer than part.prt.9.
+ *
+ * Rows are indexes into PartCache::parts(). Files of non-versioned types
+ * are single, always latest, versions of themselves.
+ */
+class PartVersionIndex
+{
+public:
+	PartVersionIndex();
+	explicit PartVersionIndex(const QFileInfoList &parts);
+
+	bool isVersioned(int row) const;
+	bool isLatest(int row) const;
+	//! Numeric version of the row, -1 when not versioned
+	int version(int row) const;
+	int latestRow(int row) const;
+	//! All versions of the part of \a row, the latest first
+	QVector<int> versionRows(int row) const;
+	QVector<int> versionRows(const QString &completeBaseName) const;
+
+	//! completeBaseName -> file name of the latest version
+	MetadataVersionsMap versionsMap() const;
+
+private:
+	//! row -> part id, -1 for non-versioned rows
+	QVector<int> m_partOf;
+	QVector<int> m_versions;
+	//! part id -> rows sorted by version, the latest first
+	QVector<QVector<int> > m_parts;
+	QHash<QString, int> m_names;
+	MetadataVersionsMap m_latest;
+};
+
+#endif // PARTVERSIONINDEX_H
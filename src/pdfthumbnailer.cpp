@@ -0,0 +1,53 @@
+#ifdef HAVE_POPPLER
+#include <QScopedPointer>
+#include <QElapsedTimer>
+
+#include <poppler-qt5/poppler-qt5.h>
+
+#include "pdfthumbnailer.h"
+
+
+QStringList PdfThumbnailer::nameFilters() const
+{
+	return QStringList() << "*.pdf";
+}
+
+QImage PdfThumbnailer::render(const QFileInfo &fi, int size, int budgetMs) const
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QScopedPointer<Poppler::Document> doc(Poppler::Document::load(fi.absoluteFilePath()));
+
+	if (!doc || doc->isLocked() || doc->numPages() < 1 || timer.elapsed() > budgetMs)
+		return QImage();
+
+	doc->setRenderHint(Poppler::Document::Antialiasing);
+	doc->setRenderHint(Poppler::Document::TextAntialiasing);
+
+	QScopedPointer<Poppler::Page> page(doc->page(0));
+
+	if (!page)
+		return QImage();
+
+	// page size is in points, 72 per inch
+	const QSizeF points = page->pageSizeF();
+	const qreal longest = qMax(points.width(), points.height());
+
+	if (longest <= 0)
+		return QImage();
+
+	const qreal dpi = size * 72.0 / longest;
+	QImage img = page->renderToImage(dpi, dpi);
+
+	if (img.isNull())
+		return QImage();
+
+	// rounding may add a pixel
+	if (img.width() > size || img.height() > size)
+		img = img.copy(0, 0, qMin(img.width(), size), qMin(img.height(), size));
+
+	return img;
+}
+
+#endif
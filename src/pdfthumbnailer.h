@@ -0,0 +1,22 @@
+#ifdef HAVE_POPPLER
+#ifndef PDFTHUMBNAILER_H
+#define PDFTHUMBNAILER_H
+
+#include "thumbnailer.h"
+
+/*!
+ * \brief First page of PDF documents rendered by poppler
+ *
+ * The page is rendered at the resolution at which it fits the thumbnail,
+ * not at the full resolution. Every call loads its own document,
+ * poppler documents must not be used from more threads at once.
+ */
+class PdfThumbnailer : public AbstractThumbnailer
+{
+public:
+	QStringList nameFilters() const;
+	QImage render(const QFileInfo &fi, int size, int budgetMs) const;
+};
+
+#endif // PDFTHUMBNAILER_H
+#endif
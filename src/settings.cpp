@@ -63,6 +63,7 @@ void Settings::load()
 
 	GUIThumbWidth = s.value("GUIThumbWidth", 32).toInt();
 	GUIPreviewWidth = s.value("GUIPreviewWidth", 256).toInt();
+	GUIThumbCacheSize = s.value("GUIThumbCacheSize", 256).toInt();
 	GUISplashEnabled = s.value("GUISplashEnabled", true).toBool();
 	GUISplashDuration = s.value("GUISplashDuration", 1500).toInt();
 	DeveloperEnabled = s.value("DeveloperEnabled", false).toBool();
@@ -72,6 +73,7 @@ void Settings::load()
 	ExtensionsProductViewPosition = s.value("Extensions/ProductView/position").toPoint();
 	ProeExecutable = s.value("ExternalPrograms/ProE/Executable", "proe.exe").toString();
 	TextEditorPath = s.value("ExternalPrograms/TextEditorPath").toString();
+	GroupProeVersions = s.value("GroupProeVersions", false).toBool();
 
 	MainTabs = s.value("Tabs/Open", QStringList()).toStringList();
 	ActiveMainTab = s.value("Tabs/Active", 0).toInt();
@@ -113,6 +115,7 @@ void Settings::save()
 
 	s.setValue("GUIThumbWidth", GUIThumbWidth);
 	s.setValue("GUIPreviewWidth", GUIPreviewWidth);
+	s.setValue("GUIThumbCacheSize", GUIThumbCacheSize);
 	s.setValue("GUISplashEnabled", GUISplashEnabled);
 	s.setValue("GUISplashDuration", GUISplashDuration);
 	s.setValue("DeveloperEnabled", DeveloperEnabled);
@@ -120,6 +123,7 @@ void Settings::save()
 	s.setValue("ExtensionsProductViewPath", ExtensionsProductViewPath);
 	s.setValue("ExternalPrograms/ProE/Executable", ProeExecutable);
 	s.setValue("ExternalPrograms/TextEditorPath", TextEditorPath);
+	s.setValue("GroupProeVersions", GroupProeVersions);
 	s.setValue("Extensions/ProductView/geometry", ExtensionsProductViewGeometry);
 	s.setValue("Extensions/ProductView/position", ExtensionsProductViewPosition);
 
@@ -6,16 +6,9 @@
 #include "filefilters/filtergroup.h"
 #include "datasourcemodel.h"
 #include "metadata.h"
+#include "datasourcepaths.h"
 
 
-#define METADATA_DIR "0000-index"
-#define THUMBNAILS_DIR "0000-index/thumbnails"
-#define PROTOTYPE_DIR "0000-index/prototypes"
-// If presented - display only the logo
-#define LOGO_FILE "logo.png"
-// if presented - display logo and text
-#define LOGO_TEXT_FILE "logo-text.png"
-#define METADATA_FILE "metadata.ini"
 #define DEFAULT_WDIR QDir::homePath() + "/ZIMA-CAD-Parts"
 
 
@@ -97,6 +90,8 @@ public:
 
 	//! Size of the thumbnails in FileModel
 	int GUIThumbWidth;
+	//! Size limit of the local thumbnail cache in MB, 0 disables eviction
+	int GUIThumbCacheSize;
 	//! Size of the preview in FileModel
 	int GUIPreviewWidth;
 	//! Flag if the splash creen should be shown
@@ -137,6 +132,8 @@ public:
 
 	//! Flag to show Pro/E versions \todo what is it?
 	bool ShowProeVersions;
+	//! Show older Pro/E versions as children of the latest one
+	bool GroupProeVersions;
 
 	//! Available languages in QLocale::name() form (en_EN,...)
 	QStringList Languages;
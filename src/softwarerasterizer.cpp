@@ -0,0 +1,85 @@
+#include <cmath>
+#include <limits>
+
+#include "softwarerasterizer.h"
+
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height)
+	: m_width(width),
+	  m_height(height),
+	  m_depth(width * height, -std::numeric_limits<float>::infinity()),
+	  m_color(width * height, 0)
+{
+}
+
+void SoftwareRasterizer::drawTriangle(const float *a, const float *b, const float *c, quint32 color)
+{
+	float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+
+	// degenerate, or NaN or overflowing coordinates
+	if (!(std::fabs(area) > 1e-8f) || !std::isfinite(area))
+		return;
+
+	// counter clockwise on the screen
+	if (area < 0)
+	{
+		std::swap(b, c);
+		area = -area;
+	}
+
+	// clamped to the canvas before the conversion, huge floats do not fit into int
+	const float left = qMax(0.0f, std::floor(qMin(a[0], qMin(b[0], c[0]))));
+	const float right = qMin(float(m_width - 1), std::ceil(qMax(a[0], qMax(b[0], c[0]))));
+	const float top = qMax(0.0f, std::floor(qMin(a[1], qMin(b[1], c[1]))));
+	const float bottom = qMin(float(m_height - 1), std::ceil(qMax(a[1], qMax(b[1], c[1]))));
+
+	if (!(left <= right && top <= bottom))
+		return;
+
+	const int minX = int(left);
+	const int maxX = int(right);
+	const int minY = int(top);
+	const int maxY = int(bottom);
+
+	// edge functions e(x, y) = A*x + B*y + C, weights of the opposite vertices
+	const float A0 = b[1] - c[1], B0 = c[0] - b[0], C0 = (c[1] - b[1]) * b[0] - (c[0] - b[0]) * b[1];
+	const float A1 = c[1] - a[1], B1 = a[0] - c[0], C1 = (a[1] - c[1]) * c[0] - (a[0] - c[0]) * c[1];
+	const float A2 = a[1] - b[1], B2 = b[0] - a[0], C2 = (b[1] - a[1]) * a[0] - (b[0] - a[0]) * a[1];
+
+	// depth is linear in screen space as well
+	const float Zx = (A0 * a[2] + A1 * b[2] + A2 * c[2]) / area;
+	const float Zy = (B0 * a[2] + B1 * b[2] + B2 * c[2]) / area;
+	const float Z0 = (C0 * a[2] + C1 * b[2] + C2 * c[2]) / area;
+
+	const float x0 = minX + 0.5f;
+	const int cnt = maxX - minX + 1;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		const float py = y + 0.5f;
+		const float e0 = A0 * x0 + B0 * py + C0;
+		const float e1 = A1 * x0 + B1 * py + C1;
+		const float e2 = A2 * x0 + B2 * py + C2;
+		const float z = Zx * x0 + Zy * py + Z0;
+
+		float *depth = m_depth.data() + y * m_width + minX;
+		quint32 *pixels = m_color.data() + y * m_width + minX;
+
+		for (int i = 0; i < cnt; i++)
+		{
+			const float fi = i;
+			const float pz = z + Zx * fi;
+			const bool inside = (e0 + A0 * fi >= 0) & (e1 + A1 * fi >= 0)
+								& (e2 + A2 * fi >= 0) & (pz > depth[i]);
+
+			depth[i] = inside ? pz : depth[i];
+			pixels[i] = inside ? color : pixels[i];
+		}
+	}
+}
+
+QImage SoftwareRasterizer::image() const
+{
+	return QImage(reinterpret_cast<const uchar*>(m_color.constData()), m_width, m_height,
+				  QImage::Format_ARGB32_Premultiplied).copy();
+}
@@ -0,0 +1,37 @@
+#ifndef SOFTWARERASTERIZER_H
+#define SOFTWARERASTERIZER_H
+
+#include <QImage>
+#include <QVector>
+
+/*!
+ * \brief Flat shaded triangle rasterizer with a z-buffer
+ *
+ * Used to render thumbnails off the GUI thread without OpenGL.
+ * Triangles are filled by evaluating their edge functions over the
+ * bounding box. The inner loop has no branches and no loop carried
+ * dependencies, so the compiler can vectorize it.
+ */
+class SoftwareRasterizer
+{
+public:
+	SoftwareRasterizer(int width, int height);
+
+	/*!
+	 * Draw a triangle. Vertices are x, y in pixels (y down) and depth,
+	 * which grows towards the viewer. \a color is premultiplied ARGB.
+	 * Vertices must be finite.
+	 */
+	void drawTriangle(const float *a, const float *b, const float *c, quint32 color);
+
+	//! Rendered image, transparent where nothing was drawn
+	QImage image() const;
+
+private:
+	int m_width;
+	int m_height;
+	QVector<float> m_depth;
+	QVector<quint32> m_color;
+};
+
+#endif // SOFTWARERASTERIZER_H
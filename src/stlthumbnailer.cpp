@@ -0,0 +1,246 @@
+#include <QFile>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+#include "stlthumbnailer.h"
+#include "softwarerasterizer.h"
+#include "imagescaler.h"
+
+// Larger meshes are decimated
+#define STL_MAX_TRIANGLES 200000
+// Approximate size of one facet in ASCII STL, used to guess the decimation
+#define STL_ASCII_FACET_BYTES 250
+// Time budget is checked after this many triangles or lines
+#define STL_CHECK_INTERVAL 4096
+// Rendered in a higher resolution and downscaled for antialiasing
+#define STL_SUPERSAMPLE 2
+// Empty space around the mesh, fraction of the size
+#define STL_MARGIN 0.05f
+// Shading of the mesh
+#define STL_AMBIENT 0.3f
+#define STL_DIFFUSE 0.7f
+#define STL_COLOR_R 150
+#define STL_COLOR_G 170
+#define STL_COLOR_B 200
+
+
+QStringList StlThumbnailer::nameFilters() const
+{
+	return QStringList() << "*.stl";
+}
+
+QImage StlThumbnailer::render(const QFileInfo &fi, int size, int budgetMs) const
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QFile f(fi.absoluteFilePath());
+
+	if (!f.open(QIODevice::ReadOnly))
+		return QImage();
+
+	const qint64 fileSize = f.size();
+	Mesh mesh;
+	bool ok;
+
+	if (fileSize >= 84)
+	{
+		const uchar *data = f.map(0, fileSize);
+
+		if (!data)
+			return QImage();
+
+		const quint32 count = qFromLittleEndian<quint32>(data + 80);
+		const bool solid = qstrncmp(reinterpret_cast<const char*>(data), "solid", 5) == 0;
+
+		// ASCII files start with "solid", but so do some binary ones
+		if (qint64(count) * 50 + 84 == fileSize || (!solid && qint64(count) * 50 + 84 < fileSize))
+			ok = readBinary(data, fileSize, &mesh, timer, budgetMs);
+		else
+			ok = readAscii(f, &mesh, timer, budgetMs);
+
+		f.unmap(const_cast<uchar*>(data));
+	}
+	else
+		ok = readAscii(f, &mesh, timer, budgetMs);
+
+	if (!ok || mesh.isEmpty())
+		return QImage();
+
+	return rasterize(mesh, size, timer, budgetMs);
+}
+
+bool StlThumbnailer::readBinary(const uchar *data, qint64 size, Mesh *mesh, const QElapsedTimer &timer, int budgetMs) const
+{
+	// the count may be wrong in truncated files
+	const qint64 count = qMin<qint64>(qFromLittleEndian<quint32>(data + 80), (size - 84) / 50);
+	const qint64 stride = qMax<qint64>(1, (count + STL_MAX_TRIANGLES - 1) / STL_MAX_TRIANGLES);
+
+	mesh->reserve(int(count / stride + 1) * 9);
+
+	for (qint64 i = 0, n = 0; i < count; i += stride, n++)
+	{
+		if (n % STL_CHECK_INTERVAL == 0 && timer.elapsed() > budgetMs)
+			return false;
+
+		// 50 bytes per triangle: normal, three vertices, attribute
+		const uchar *v = data + 84 + i * 50 + 12;
+
+		for (int j = 0; j < 9; j++)
+		{
+			const quint32 bits = qFromLittleEndian<quint32>(v + j * 4);
+			float value;
+
+			memcpy(&value, &bits, 4);
+			*mesh << value;
+		}
+	}
+
+	return true;
+}
+
+bool StlThumbnailer::readAscii(QFile &f, Mesh *mesh, const QElapsedTimer &timer, int budgetMs) const
+{
+	const qint64 facets = f.size() / STL_ASCII_FACET_BYTES;
+	const qint64 stride = qMax<qint64>(1, (facets + STL_MAX_TRIANGLES - 1) / STL_MAX_TRIANGLES);
+	qint64 facet = 0;
+	qint64 lines = 0;
+	float vertices[9];
+	int vertex = 0;
+
+	f.seek(0);
+
+	while (!f.atEnd())
+	{
+		if (++lines % STL_CHECK_INTERVAL == 0 && timer.elapsed() > budgetMs)
+			return false;
+
+		QByteArray line = f.readLine().simplified();
+
+		if (line.startsWith("vertex"))
+		{
+			if (facet % stride != 0 || vertex >= 3)
+				continue;
+
+			QList<QByteArray> parts = line.split(' ');
+
+			if (parts.count() != 4)
+				return false;
+
+			// QByteArray::toFloat() does not depend on the locale
+			for (int j = 0; j < 3; j++)
+				vertices[vertex * 3 + j] = parts[j + 1].toFloat();
+
+			vertex++;
+		}
+		else if (line.startsWith("endfacet"))
+		{
+			if (vertex == 3)
+			{
+				for (int j = 0; j < 9; j++)
+					*mesh << vertices[j];
+			}
+
+			vertex = 0;
+			facet++;
+		}
+	}
+
+	return true;
+}
+
+QImage StlThumbnailer::rasterize(const Mesh &mesh, int size, const QElapsedTimer &timer, int budgetMs) const
+{
+	// isometric view from the front right top, Z up
+	const float s3 = 1.0f / std::sqrt(3.0f);
+	const float s2 = 1.0f / std::sqrt(2.0f);
+	const float s6 = 1.0f / std::sqrt(6.0f);
+	const float xAxis[3] = { s2, s2, 0 };
+	const float yAxis[3] = { -s6, s6, 2 * s6 };
+	const float zAxis[3] = { s3, -s3, s3 };
+	// light from the upper left of the viewer, in view space
+	const float ll = std::sqrt(0.3f * 0.3f + 0.5f * 0.5f + 1.0f);
+	const float light[3] = { -0.3f / ll, 0.5f / ll, 1.0f / ll };
+
+	const int triangles = mesh.count() / 9;
+	QVector<float> view(mesh.count());
+	float minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+
+	for (int i = 0; i < mesh.count(); i += 3)
+	{
+		const float *p = mesh.constData() + i;
+		float *v = view.data() + i;
+
+		v[0] = p[0] * xAxis[0] + p[1] * xAxis[1] + p[2] * xAxis[2];
+		v[1] = p[0] * yAxis[0] + p[1] * yAxis[1] + p[2] * yAxis[2];
+		v[2] = p[0] * zAxis[0] + p[1] * zAxis[1] + p[2] * zAxis[2];
+
+		if (!std::isfinite(v[0]) || !std::isfinite(v[1]) || !std::isfinite(v[2]))
+			continue;
+
+		minX = qMin(minX, v[0]);
+		maxX = qMax(maxX, v[0]);
+		minY = qMin(minY, v[1]);
+		maxY = qMax(maxY, v[1]);
+	}
+
+	if (!(minX <= maxX && minY <= maxY))
+		return QImage();
+
+	const int canvas = size * STL_SUPERSAMPLE;
+	const float extent = qMax(maxX - minX, maxY - minY);
+	const float scale = extent > 0 ? canvas * (1 - 2 * STL_MARGIN) / extent : 1;
+	const float cx = (minX + maxX) / 2;
+	const float cy = (minY + maxY) / 2;
+
+	SoftwareRasterizer raster(canvas, canvas);
+
+	for (int t = 0; t < triangles; t++)
+	{
+		if (t % STL_CHECK_INTERVAL == 0 && timer.elapsed() > budgetMs)
+			return QImage();
+
+		const float *v = view.constData() + t * 9;
+
+		float screen[9];
+		bool finite = true;
+
+		for (int j = 0; j < 3; j++)
+		{
+			screen[j * 3] = (v[j * 3] - cx) * scale + canvas / 2;
+			screen[j * 3 + 1] = canvas / 2 - (v[j * 3 + 1] - cy) * scale;
+			screen[j * 3 + 2] = v[j * 3 + 2];
+
+			finite &= std::isfinite(screen[j * 3]) && std::isfinite(screen[j * 3 + 1])
+					  && std::isfinite(screen[j * 3 + 2]);
+		}
+
+		// malformed files, skipped by the bounding box as well
+		if (!finite)
+			continue;
+
+		// flat shading by the face normal, both sides are lit
+		const float ux = v[3] - v[0], uy = v[4] - v[1], uz = v[5] - v[2];
+		const float wx = v[6] - v[0], wy = v[7] - v[1], wz = v[8] - v[2];
+		const float nx = uy * wz - uz * wy;
+		const float ny = uz * wx - ux * wz;
+		const float nz = ux * wy - uy * wx;
+		const float len = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+		// overflowing normals of huge triangles as well
+		if (!(len > 0) || !std::isfinite(len))
+			continue;
+
+		const float diffuse = std::fabs(nx * light[0] + ny * light[1] + nz * light[2]) / len;
+		const float shade = STL_AMBIENT + STL_DIFFUSE * diffuse;
+		const quint32 color = 0xff000000
+			| (quint32(STL_COLOR_R * shade) << 16)
+			| (quint32(STL_COLOR_G * shade) << 8)
+			| quint32(STL_COLOR_B * shade);
+
+		raster.drawTriangle(screen, screen + 3, screen + 6, color);
+	}
+
+	return ImageScaler::scaled(raster.image(), size, size);
+}
@@ -0,0 +1,34 @@
+#ifndef STLTHUMBNAILER_H
+#define STLTHUMBNAILER_H
+
+#include <QVector>
+#include <QElapsedTimer>
+
+#include "thumbnailer.h"
+
+class QFile;
+
+/*!
+ * \brief Isometric view of STL meshes rendered by SoftwareRasterizer
+ *
+ * Binary STL is memory mapped, ASCII STL is streamed. Meshes with more
+ * than STL_MAX_TRIANGLES triangles are decimated by taking every n-th
+ * triangle, which is good enough at thumbnail sizes and keeps the time
+ * spent on multi-hundred-MB meshes bounded.
+ */
+class StlThumbnailer : public AbstractThumbnailer
+{
+public:
+	QStringList nameFilters() const;
+	QImage render(const QFileInfo &fi, int size, int budgetMs) const;
+
+private:
+	//! Triangles as 9 floats each
+	typedef QVector<float> Mesh;
+
+	bool readBinary(const uchar *data, qint64 size, Mesh *mesh, const QElapsedTimer &timer, int budgetMs) const;
+	bool readAscii(QFile &f, Mesh *mesh, const QElapsedTimer &timer, int budgetMs) const;
+	QImage rasterize(const Mesh &mesh, int size, const QElapsedTimer &timer, int budgetMs) const;
+};
+
+#endif // STLTHUMBNAILER_H
@@ -25,7 +25,7 @@ void ThreadWorker::start()
 
 void ThreadWorker::stop()
 {
-	QThread::currentThread()->requestInterruption();
+	thread()->requestInterruption();
 }
 
 void ThreadWorker::quit()
@@ -0,0 +1,237 @@
+#include <QThreadPool>
+#include <QDateTime>
+#include <QTimer>
+#include <algorithm>
+
+#include "thumbnailcache.h"
+#include "thumbnailmanager.h"
+
+// Memory used by pixmaps of all directories, in bytes
+#define THUMBNAIL_CACHE_BUDGET (128 * 1024 * 1024)
+// Loaded thumbnails are announced after this many images...
+#define THUMBNAIL_BATCH_SIZE 16
+// ...or this many milliseconds after the first one
+#define THUMBNAIL_BATCH_MSECS 30
+// Loaded thumbnail sizes, powers of two between these
+#define THUMBNAIL_TIER_MIN 32
+#define THUMBNAIL_TIER_MAX 512
+
+
+ThumbnailJob::ThumbnailJob(QObject *cache, const QString &key, const ThumbnailSource &source, int size)
+	: m_cache(cache),
+	  m_key(key),
+	  m_source(source),
+	  m_size(size)
+{
+}
+
+void ThumbnailJob::run()
+{
+	bool stored;
+	QImage img = ThumbnailWorker::load(m_source, m_size, &stored);
+
+	QMetaObject::invokeMethod(m_cache, "imageReady", Qt::QueuedConnection,
+							  Q_ARG(QString, m_key),
+							  Q_ARG(QImage, img),
+							  Q_ARG(bool, stored));
+}
+
+
+ThumbnailCache *ThumbnailCache::m_instance = 0;
+
+ThumbnailCache *ThumbnailCache::get()
+{
+	if (!m_instance)
+		m_instance = new ThumbnailCache;
+
+	return m_instance;
+}
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+	: QObject(parent),
+	  m_cost(0),
+	  m_budget(THUMBNAIL_CACHE_BUDGET),
+	  m_clock(0),
+	  m_stored(0)
+{
+	m_pool = new QThreadPool(this);
+
+	m_batchTimer = new QTimer(this);
+	m_batchTimer->setSingleShot(true);
+	m_batchTimer->setInterval(THUMBNAIL_BATCH_MSECS);
+
+	connect(m_batchTimer, SIGNAL(timeout()), this, SLOT(flushLoaded()));
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	m_pool->clear();
+	m_pool->waitForDone();
+}
+
+QString ThumbnailCache::key(const ThumbnailSource &source, int size)
+{
+	if (!source.pack.isEmpty())
+	{
+		return QString("%1|%2|%3|%4")
+				.arg(source.pack)
+				.arg(source.packModified)
+				.arg(size)
+				.arg(QFileInfo(source.path).baseName());
+	}
+
+	return QString("%1|%2|%3")
+			.arg(source.path)
+			.arg(source.modified)
+			.arg(size);
+}
+
+QList<int> ThumbnailCache::tiers()
+{
+	QList<int> ret;
+
+	for (int t = THUMBNAIL_TIER_MIN; t <= THUMBNAIL_TIER_MAX; t *= 2)
+		ret << t;
+
+	return ret;
+}
+
+int ThumbnailCache::tier(int width)
+{
+	int t = THUMBNAIL_TIER_MIN;
+
+	while (t < width && t < THUMBNAIL_TIER_MAX)
+		t *= 2;
+
+	return t;
+}
+
+bool ThumbnailCache::contains(const QString &key) const
+{
+	return m_entries.contains(key);
+}
+
+QPixmap ThumbnailCache::pixmap(const QString &key)
+{
+	auto it = m_entries.find(key);
+
+	if (it == m_entries.end())
+		return QPixmap();
+
+	it.value().lastUse = ++m_clock;
+	return it.value().pixmap;
+}
+
+bool ThumbnailCache::isLoading(const QString &key) const
+{
+	return m_loading.contains(key);
+}
+
+void ThumbnailCache::load(const QString &key, const ThumbnailSource &source, int size)
+{
+	if (m_entries.contains(key) || m_loading.contains(key))
+		return;
+
+	m_loading.insert(key);
+	m_pool->start(new ThumbnailJob(this, key, source, size));
+}
+
+int ThumbnailCache::maxLoading() const
+{
+	return m_pool->maxThreadCount() * 2;
+}
+
+void ThumbnailCache::acquire(const QString &key)
+{
+	m_refs[key]++;
+}
+
+void ThumbnailCache::release(const QString &key)
+{
+	auto it = m_refs.find(key);
+
+	if (it == m_refs.end())
+		return;
+
+	if (--it.value() <= 0)
+		m_refs.erase(it);
+}
+
+int ThumbnailCache::acquiredCount() const
+{
+	return m_refs.count();
+}
+
+int ThumbnailCache::takeStoredCount()
+{
+	int ret = m_stored;
+	m_stored = 0;
+	return ret;
+}
+
+void ThumbnailCache::imageReady(const QString &key, const QImage &image, bool stored)
+{
+	if (stored)
+		m_stored++;
+
+	m_loading.remove(key);
+
+	// QPixmap can be created only in the GUI thread, null pixmaps are
+	// cached too, so broken images are not loaded again and again
+	Entry e;
+	e.pixmap = QPixmap::fromImage(image);
+	e.cost = qMax(1, image.width() * image.height() * 4);
+	e.lastUse = ++m_clock;
+
+	m_entries.insert(key, e);
+	m_cost += e.cost;
+
+	evict();
+
+	m_loaded << key;
+
+	if (m_loaded.count() >= THUMBNAIL_BATCH_SIZE)
+		flushLoaded();
+	else if (!m_batchTimer->isActive())
+		m_batchTimer->start();
+}
+
+void ThumbnailCache::flushLoaded()
+{
+	m_batchTimer->stop();
+
+	if (m_loaded.isEmpty())
+		return;
+
+	QStringList keys = m_loaded;
+	m_loaded.clear();
+
+	emit loaded(keys);
+}
+
+void ThumbnailCache::evict()
+{
+	if (m_cost <= m_budget)
+		return;
+
+	QList<QPair<quint64, QString> > unused;
+	auto it = m_entries.constBegin();
+
+	while (it != m_entries.constEnd())
+	{
+		if (!m_refs.contains(it.key()))
+			unused << qMakePair(it.value().lastUse, it.key());
+		++it;
+	}
+
+	std::sort(unused.begin(), unused.end());
+
+	// leave some space, so that every new thumbnail does not evict
+	const qint64 target = m_budget - m_budget / 10;
+
+	for (int i = 0; i < unused.count() && m_cost > target; i++)
+	{
+		m_cost -= m_entries[unused[i].second].cost;
+		m_entries.remove(unused[i].second);
+	}
+}
@@ -0,0 +1,151 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QPixmap>
+#include <QImage>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRunnable>
+#include <QStringList>
+
+class QTimer;
+
+class QThreadPool;
+
+/*!
+ * \brief Source of a thumbnail: an image file, an entry of a ThumbnailPack
+ * or a part rendered by an AbstractThumbnailer
+ */
+struct ThumbnailSource {
+	//! absolute path of the image file, it does not have to exist when packed
+	QString path;
+	//! size of the file, -1 when not known (packed)
+	qint64 size;
+	//! modification time of the file in ms since epoch, -1 when not known (packed)
+	qint64 modified;
+	//! path of the pack containing the thumbnail, empty when not packed
+	QString pack;
+	//! modification time of the pack in ms since epoch
+	qint64 packModified;
+	//! file is a part rendered by AbstractThumbnailer::find()
+	bool render;
+
+	ThumbnailSource() : size(-1), modified(-1), packModified(0), render(false) {}
+	/*!
+	 * Sources are passed between threads, so the file attributes are copied
+	 * out of \a fi: a QFileInfo shared by more threads fills its lazy cache
+	 * without locking.
+	 */
+	explicit ThumbnailSource(const QFileInfo &fi, bool render = false)
+		: path(fi.absoluteFilePath()),
+		  size(fi.size()),
+		  modified(fi.lastModified().toMSecsSinceEpoch()),
+		  packModified(0),
+		  render(render) {}
+};
+
+/*!
+ * \brief Loads one thumbnail on the ThumbnailCache's thread pool
+ *
+ * The decoded QImage is handed back to the cache by a queued call,
+ * the QPixmap is created in the GUI thread.
+ */
+class ThumbnailJob : public QRunnable
+{
+public:
+	ThumbnailJob(QObject *cache, const QString &key, const ThumbnailSource &source, int size);
+
+	void run();
+
+private:
+	QObject *m_cache;
+	QString m_key;
+	ThumbnailSource m_source;
+	int m_size;
+};
+
+/*!
+ * \brief Process-wide cache of loaded thumbnails
+ *
+ * Thumbnails are keyed by key(): the source image path, its modification
+ * time and the thumbnail size. All ThumbnailManagers share this cache,
+ * so a thumbnail directory included by several directories (or shown
+ * in several tabs) is loaded and held only once, and a thumbnail
+ * requested by more managers is loaded by a single job.
+ *
+ * Managers acquire() thumbnails they display. Acquired thumbnails are
+ * never evicted, the others are evicted in LRU order when the cache
+ * exceeds its memory budget.
+ *
+ * Thumbnails are loaded only in a few power of two sizes, see tier().
+ * Any other width is scaled down from the nearest larger tier, so that
+ * changing the thumbnail width does not reload everything.
+ */
+class ThumbnailCache : public QObject
+{
+	Q_OBJECT
+public:
+	static ThumbnailCache *get();
+
+	static QString key(const ThumbnailSource &source, int size);
+	//! All sizes thumbnails are loaded in, ascending
+	static QList<int> tiers();
+	//! The smallest tier not smaller than \a width, or the largest one
+	static int tier(int width);
+
+	bool contains(const QString &key) const;
+	//! Cached pixmap, null if not cached
+	QPixmap pixmap(const QString &key);
+	bool isLoading(const QString &key) const;
+	//! Start loading the thumbnail unless it is cached or being loaded
+	void load(const QString &key, const ThumbnailSource &source, int size);
+	//! Number of loads that can run in parallel
+	int maxLoading() const;
+
+	void acquire(const QString &key);
+	void release(const QString &key);
+	//! Number of thumbnails acquired by any manager
+	int acquiredCount() const;
+
+	//! Number of thumbnails stored in ThumbnailDiskCache since the last call
+	int takeStoredCount();
+
+signals:
+	//! Thumbnails were loaded, emitted in batches
+	void loaded(const QStringList &keys);
+
+private slots:
+	void imageReady(const QString &key, const QImage &image, bool stored);
+	void flushLoaded();
+
+private:
+	struct Entry {
+		QPixmap pixmap;
+		qint64 cost;
+		quint64 lastUse;
+	};
+
+	static ThumbnailCache *m_instance;
+
+	QHash<QString, Entry> m_entries;
+	QHash<QString, int> m_refs;
+	QSet<QString> m_loading;
+	//! loaded keys not announced yet
+	QStringList m_loaded;
+	QTimer *m_batchTimer;
+	QThreadPool *m_pool;
+	qint64 m_cost;
+	qint64 m_budget;
+	quint64 m_clock;
+	int m_stored;
+
+	ThumbnailCache(QObject *parent = 0);
+	~ThumbnailCache();
+
+	void evict();
+};
+
+#endif // THUMBNAILCACHE_H
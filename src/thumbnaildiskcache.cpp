@@ -0,0 +1,218 @@
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QDir>
+#include <algorithm>
+
+#include "thumbnaildiskcache.h"
+
+// "ZCPT", identifies thumbnail files
+#define THUMB_MAGIC 0x5a435054
+// Increase when the file format changes
+#define THUMB_VERSION 1
+// Hits of files older than this are recorded for LRU
+#define THUMB_TOUCH_SECS (24 * 3600)
+// Rendering of a failed part is tried again after this time, the failure
+// may have been caused by a busy machine or a slow share
+#define THUMB_FAILED_RETRY_SECS (24 * 3600)
+// Maximum number of failure markers kept
+#define THUMB_FAILED_MAX 10000
+
+namespace {
+	struct Header {
+		quint32 magic;
+		quint32 version;
+		quint32 width;
+		quint32 height;
+	};
+}
+
+
+QImage ThumbnailDiskCache::load(const ThumbnailSource &source, int width)
+{
+	QFile f(cachePath(source, width));
+
+	if (!f.open(QIODevice::ReadOnly))
+		return QImage();
+
+	Header h;
+
+	if (f.read((char*) &h, sizeof(h)) != sizeof(h)
+			|| h.magic != THUMB_MAGIC || h.version != THUMB_VERSION
+			|| h.width == 0 || h.height == 0 || h.width > 4096 || h.height > 4096)
+		return QImage();
+
+	const int lineBytes = h.width * 4;
+
+	if (f.size() != qint64(sizeof(h)) + qint64(lineBytes) * h.height)
+		return QImage();
+
+	QImage img(h.width, h.height, QImage::Format_ARGB32_Premultiplied);
+
+	for (quint32 y = 0; y < h.height; y++)
+	{
+		if (f.read((char*) img.scanLine(y), lineBytes) != lineBytes)
+			return QImage();
+	}
+
+	QDateTime now = QDateTime::currentDateTime();
+
+	if (f.fileTime(QFileDevice::FileModificationTime).secsTo(now) > THUMB_TOUCH_SECS)
+		f.setFileTime(now, QFileDevice::FileModificationTime);
+
+	return img;
+}
+
+bool ThumbnailDiskCache::store(const ThumbnailSource &source, int width, const QImage &image)
+{
+	if (image.isNull())
+		return false;
+
+	QString path = cachePath(source, width);
+
+	if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+		return false;
+
+	QImage img = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+	Header h;
+	h.magic = THUMB_MAGIC;
+	h.version = THUMB_VERSION;
+	h.width = img.width();
+	h.height = img.height();
+
+	// written to a temporary file and renamed, readers never see a partial file
+	QSaveFile f(path);
+
+	if (!f.open(QIODevice::WriteOnly))
+		return false;
+
+	f.write((const char*) &h, sizeof(h));
+
+	for (int y = 0; y < img.height(); y++)
+		f.write((const char*) img.constScanLine(y), img.width() * 4);
+
+	return f.commit();
+}
+
+bool ThumbnailDiskCache::hasFailed(const ThumbnailSource &source)
+{
+	// the width 0 is never used by thumbnails
+	QFile f(cachePath(source, 0));
+
+	if (!f.open(QIODevice::ReadOnly))
+		return false;
+
+	bool ok;
+	qint64 failed = f.read(sizeof(Header)).toLongLong(&ok);
+
+	return ok && failed > QDateTime::currentMSecsSinceEpoch() - qint64(THUMB_FAILED_RETRY_SECS) * 1000;
+}
+
+bool ThumbnailDiskCache::storeFailed(const ThumbnailSource &source)
+{
+	QString path = cachePath(source, 0);
+
+	if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+		return false;
+
+	// the failure time, shorter than Header, which tells markers apart in evict()
+	QSaveFile f(path);
+
+	if (!f.open(QIODevice::WriteOnly))
+		return false;
+
+	f.write(QByteArray::number(QDateTime::currentMSecsSinceEpoch()));
+	return f.commit();
+}
+
+void ThumbnailDiskCache::evict(qint64 maxBytes)
+{
+	struct Item {
+		QDateTime modified;
+		qint64 size;
+		QString path;
+	};
+
+	QList<Item> items;
+	QList<Item> markers;
+	qint64 total = 0;
+	const QDateTime expired = QDateTime::currentDateTime().addSecs(-THUMB_FAILED_RETRY_SECS);
+	QDirIterator it(cacheDir(), QDir::Files, QDirIterator::Subdirectories);
+
+	while (it.hasNext())
+	{
+		it.next();
+
+		Item i;
+		i.modified = it.fileInfo().lastModified();
+		i.size = it.fileInfo().size();
+		i.path = it.filePath();
+
+		if (i.size >= qint64(sizeof(Header)))
+		{
+			total += i.size;
+			items << i;
+
+		// failure markers take no space, they are limited by age and count
+		} else if (i.modified < expired) {
+			QFile::remove(i.path);
+
+		} else {
+			markers << i;
+		}
+	}
+
+	auto lessRecent = [](const Item &a, const Item &b) {
+		return a.modified < b.modified;
+	};
+
+	if (markers.count() > THUMB_FAILED_MAX)
+	{
+		std::sort(markers.begin(), markers.end(), lessRecent);
+
+		for (int i = 0; i < markers.count() - THUMB_FAILED_MAX; i++)
+			QFile::remove(markers[i].path);
+	}
+
+	if (total <= maxBytes)
+		return;
+
+	std::sort(items.begin(), items.end(), lessRecent);
+
+	// leave some space so that the next visit does not evict again
+	const qint64 target = maxBytes - maxBytes / 10;
+
+	foreach (const Item &i, items)
+	{
+		if (total <= target)
+			break;
+
+		if (QFile::remove(i.path))
+			total -= i.size;
+	}
+}
+
+void ThumbnailDiskCache::clear()
+{
+	QDir(cacheDir()).removeRecursively();
+}
+
+QString ThumbnailDiskCache::cacheDir()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+}
+
+QString ThumbnailDiskCache::cachePath(const ThumbnailSource &source, int width)
+{
+	QString key = QString("%1\n%2\n%3\n%4")
+			.arg(source.path)
+			.arg(source.size)
+			.arg(source.modified)
+			.arg(width);
+
+	QString hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+	return cacheDir() + "/" + hash.left(2) + "/" + hash;
+}
@@ -0,0 +1,52 @@
+#ifndef THUMBNAILDISKCACHE_H
+#define THUMBNAILDISKCACHE_H
+
+#include <QString>
+#include <QImage>
+#include <QFileInfo>
+
+#include "thumbnailcache.h"
+
+/*!
+ * \brief Local cache of scaled thumbnails
+ *
+ * Thumbnails are stored under the user's cache directory, one file per
+ * thumbnail. The file name is a SHA-1 of the source path, its size,
+ * modification time and the thumbnail width, so a changed source or
+ * a different width simply misses. Files contain a small header followed
+ * by raw ARGB32 premultiplied pixels, which is read without decoding.
+ *
+ * Modification time of cache files is used for LRU eviction: it is
+ * refreshed on hits older than a day, and the oldest files are removed
+ * when the cache grows over Settings::GUIThumbCacheSize.
+ *
+ * Parts that could not be rendered get a marker file of width 0 holding
+ * the failure time, they are tried again once it expires.
+ *
+ * Sources are identified by their path, size and modification time
+ * captured when the directory was listed, files are not stat-ed here.
+ *
+ * All methods are thread safe.
+ */
+class ThumbnailDiskCache
+{
+public:
+	//! Cached thumbnail of \a source, null image when not cached
+	static QImage load(const ThumbnailSource &source, int width);
+	static bool store(const ThumbnailSource &source, int width, const QImage &image);
+	//! Rendering \a source failed recently and it has not changed since
+	static bool hasFailed(const ThumbnailSource &source);
+	//! Remember that \a source could not be rendered, in a file holding the failure time
+	static bool storeFailed(const ThumbnailSource &source);
+	//! Remove the least recently used thumbnails over \a maxBytes,
+	//! and expired or surplus failure markers
+	static void evict(qint64 maxBytes);
+	static void clear();
+
+	static QString cacheDir();
+
+private:
+	static QString cachePath(const ThumbnailSource &source, int width);
+};
+
+#endif // THUMBNAILDISKCACHE_H
@@ -0,0 +1,48 @@
+#include <QDir>
+
+#include "thumbnailer.h"
+#include "stlthumbnailer.h"
+#include "dxfthumbnailer.h"
+#include "olethumbnailer.h"
+#include "officethumbnailer.h"
+#include "blendthumbnailer.h"
+#include "pdfthumbnailer.h"
+
+
+QList<AbstractThumbnailer*> AbstractThumbnailer::thumbnailers()
+{
+	// created once, the first call may come from any thread
+	static const QList<AbstractThumbnailer*> list = QList<AbstractThumbnailer*>()
+		<< new StlThumbnailer
+		<< new DxfThumbnailer
+		<< new OleThumbnailer
+		<< new OfficeThumbnailer
+		<< new BlendThumbnailer
+#ifdef HAVE_POPPLER
+		<< new PdfThumbnailer
+#endif
+		;
+
+	return list;
+}
+
+AbstractThumbnailer *AbstractThumbnailer::find(const QFileInfo &fi)
+{
+	foreach (AbstractThumbnailer *t, thumbnailers())
+	{
+		if (QDir::match(t->nameFilters(), fi.fileName()))
+			return t;
+	}
+
+	return 0;
+}
+
+QStringList AbstractThumbnailer::allNameFilters()
+{
+	QStringList ret;
+
+	foreach (AbstractThumbnailer *t, thumbnailers())
+		ret << t->nameFilters();
+
+	return ret;
+}
@@ -0,0 +1,39 @@
+#ifndef THUMBNAILER_H
+#define THUMBNAILER_H
+
+#include <QImage>
+#include <QFileInfo>
+#include <QStringList>
+
+/*!
+ * \brief Renders thumbnails of parts that have no thumbnail image
+ *
+ * Thumbnailers are used by ThumbnailWorker for parts without an image
+ * in the directory or THUMBNAILS_DIR. render() runs on the ThumbnailCache
+ * thread pool and is called from several threads at once, so it must
+ * not keep any state.
+ *
+ * A new thumbnailer has to be registered in thumbnailers().
+ */
+class AbstractThumbnailer
+{
+public:
+	virtual ~AbstractThumbnailer() {}
+
+	//! Case insensitive wildcards of handled file names, e.g. "*.stl"
+	virtual QStringList nameFilters() const = 0;
+	/*!
+	 * Render the thumbnail fitting into \a size x \a size. Give up and
+	 * return a null image when it takes longer than \a budgetMs.
+	 */
+	virtual QImage render(const QFileInfo &fi, int size, int budgetMs) const = 0;
+
+	//! All registered thumbnailers
+	static QList<AbstractThumbnailer*> thumbnailers();
+	//! Thumbnailer handling \a fi, 0 if there is none
+	static AbstractThumbnailer *find(const QFileInfo &fi);
+	//! Name filters of all thumbnailers
+	static QStringList allNameFilters();
+};
+
+#endif // THUMBNAILER_H
@@ -1,54 +1,275 @@
 #include "thumbnailmanager.h"
 #include "settings.h"
+#include "partcache.h"
+#include "thumbnaildiskcache.h"
+#include "thumbnailpack.h"
+#include "imagescaler.h"
+#include "thumbnailer.h"
 #include <QtDebug>
+#include <QImageReader>
+#include <QPixmapCache>
+#include <QAtomicInt>
 
-ThumbnailWorker::ThumbnailWorker(const QString &path)
+// Number of directories with remembered thumbnails
+#define RECENT_THUMBNAIL_DIRS 8
+// Time a thumbnailer may spend on one part, in ms
+#define RENDER_BUDGET_MS 3000
+
+static QAtomicInt workerCount;
+
+ThumbnailWorker::ThumbnailWorker(const QString &path, int size, int generation, qint64 evictCacheSize)
+    : m_path(path),
+      m_size(size),
+      m_generation(generation),
+      m_evictCacheSize(evictCacheSize)
 {
-    m_path = path;
+    workerCount.ref();
+}
+
+ThumbnailWorker::~ThumbnailWorker()
+{
+    workerCount.deref();
+}
+
+int ThumbnailWorker::count()
+{
+    return workerCount.load();
+}
+
+QImage ThumbnailWorker::decode(const QString &path, int size)
+{
+    QImageReader reader(path);
+
+    return ImageScaler::readToFit(reader, QSize(size, size));
+}
+
+QImage ThumbnailWorker::load(const ThumbnailSource &source, int size, bool *stored)
+{
+    const QString baseName = QFileInfo(source.path).baseName();
+    QSharedPointer<ThumbnailPack> pack;
+    *stored = false;
+
+    if (source.render)
+        return render(source, size, stored);
+
+    if (!source.pack.isEmpty())
+    {
+        pack = ThumbnailPack::open(source.pack, source.packModified);
+
+        // the pixels are used directly, a copy detaches them from the mapping
+        QImage img = pack->image(pack->find(baseName), size).copy();
+
+        if (!img.isNull())
+            return img;
+    }
+
+    // packed files are not listed, their attributes are read only now
+    ThumbnailSource file = source;
+
+    if (file.size < 0)
+    {
+        QFileInfo fi(file.path);
+        file.size = fi.size();
+        file.modified = fi.lastModified().toMSecsSinceEpoch();
+    }
+
+    QImage img = ThumbnailDiskCache::load(file, size);
+
+    if (!img.isNull())
+        return img;
+
+    img = decode(file.path, size);
+
+    if (!img.isNull())
+    {
+        *stored = storeTiers(file, size, img);
+        return img;
+    }
+
+    // packed without the original, use the nearest packed size
+    if (pack)
+    {
+        const int entry = pack->find(baseName);
+        int nearest = 0;
+
+        foreach (int s, pack->sizes())
+        {
+            if ((nearest < size && s > nearest) || (s >= size && s < nearest))
+                nearest = s;
+        }
+
+        img = ImageScaler::scaledToFit(pack->image(entry, nearest), QSize(size, size));
+    }
+
+    return img;
+}
+
+/*!
+ * Rendered thumbnails are kept in ThumbnailDiskCache like decoded ones,
+ * keyed by the part file.
+ */
+QImage ThumbnailWorker::render(const ThumbnailSource &source, int size, bool *stored)
+{
+    QImage img = ThumbnailDiskCache::load(source, size);
+
+    if (!img.isNull())
+        return img;
+
+    // not shared with other threads
+    QFileInfo fi(source.path);
+    AbstractThumbnailer *thumbnailer = AbstractThumbnailer::find(fi);
+
+    // a part that failed or timed out is not tried again for a while
+    if (!thumbnailer || ThumbnailDiskCache::hasFailed(source))
+        return img;
+
+    img = thumbnailer->render(fi, size, RENDER_BUDGET_MS);
+
+    // stored markers are evicted by the next listing as well
+    if (img.isNull())
+        *stored = ThumbnailDiskCache::storeFailed(source);
+    else
+        *stored = storeTiers(source, size, img);
+
+    return img;
+}
+
+/*!
+ * The smaller tiers are scaled from the decoded one right away,
+ * so that a smaller thumbnail width does not decode the original again.
+ */
+bool ThumbnailWorker::storeTiers(const ThumbnailSource &source, int size, const QImage &img)
+{
+    bool stored = ThumbnailDiskCache::store(source, size, img);
+
+    foreach (int tier, ThumbnailCache::tiers())
+    {
+        if (tier >= size)
+            break;
+
+        stored |= ThumbnailDiskCache::store(source, tier, ImageScaler::scaledToFit(img, QSize(tier, tier)));
+    }
+
+    return stored;
 }
 
 void ThumbnailWorker::run()
 {
-    ThumbnailMap ret;
+    QSet<QString> found;
     Metadata* m = MetadataCache::get()->metadata(m_path);
-    getThumbs(m, &ret);
-    emit dataReady(ret);
+    getThumbs(m, &found);
+    // parts without any thumbnail image
+    findRenderable(m_path, &found);
+
+    if (isInterruptionRequested())
+        return;
+
+    emit indexReady(m_generation, ThumbnailIndex(), true);
+
+    if (m_evictCacheSize > 0)
+        ThumbnailDiskCache::evict(m_evictCacheSize);
 }
 
-void ThumbnailWorker::cacheThumbnails(const QString &dirpath, ThumbnailMap* map)
+void ThumbnailWorker::findThumbnails(const QString &dirpath, QSet<QString> *found)
 {
     if (isInterruptionRequested())
         return;
 
-    QString pmPath;
-    QFileInfo fi;
+    ThumbnailIndex batch;
     QDir d(dirpath);
 
-    foreach(QString i, d.entryList(QStringList() << "*.png" << "*.jpg" << "*.jpeg", QDir::Files | QDir::Readable))
+    // file sizes and times are needed for the disk cache keys
+    foreach(const QFileInfo &fi, d.entryInfoList(QStringList() << "*.png" << "*.jpg" << "*.jpeg", QDir::Files | QDir::Readable))
     {
-        if (isInterruptionRequested())
-            return;
-
-        fi.setFile(i);
-        if (map->contains(fi.baseName()))
+        if (found->contains(fi.baseName()))
             continue;
-        pmPath = dirpath + "/" + i;
-        map->insert(fi.baseName(), qMakePair(pmPath, QPixmap(pmPath).scaled(Settings::get()->GUIThumbWidth,
-                                                                            Settings::get()->GUIThumbWidth,
-                                                                            Qt::KeepAspectRatio)));
+        found->insert(fi.baseName());
+        batch.insert(fi.baseName(), ThumbnailSource(fi));
     };
+
+    if (!batch.isEmpty())
+        emit indexReady(m_generation, batch, false);
 }
 
-void ThumbnailWorker::getThumbs(Metadata *m, ThumbnailMap* map)
+bool ThumbnailWorker::findPackedThumbnails(const QString &path, QSet<QString> *found)
+{
+    if (isInterruptionRequested())
+        return true;
+
+    QFileInfo packFi(path + "/" + THUMBNAILS_PACK);
+
+    if (!packFi.exists())
+        return false;
+
+    // the pack is used only when it is newer than the thumbnails directory
+    QFileInfo dirFi(path + "/" + THUMBNAILS_DIR);
+
+    if (dirFi.exists() && dirFi.lastModified() > packFi.lastModified())
+        return false;
+
+    QSharedPointer<ThumbnailPack> pack = ThumbnailPack::open(packFi.absoluteFilePath(),
+                                                             packFi.lastModified().toMSecsSinceEpoch());
+
+    if (!pack->isValid() || !pack->hasSize(m_size))
+        return false;
+
+    ThumbnailIndex batch;
+    const QString dir = dirFi.absoluteFilePath() + "/";
+    const int cnt = pack->count();
+
+    for (int i = 0; i < cnt; i++)
+    {
+        QString name = pack->baseName(i);
+
+        if (found->contains(name))
+            continue;
+
+        ThumbnailSource src;
+        src.path = dir + pack->fileName(i);
+        src.pack = packFi.absoluteFilePath();
+        src.packModified = pack->lastModified().toMSecsSinceEpoch();
+
+        found->insert(name);
+        batch.insert(name, src);
+    }
+
+    if (!batch.isEmpty())
+        emit indexReady(m_generation, batch, false);
+
+    return true;
+}
+
+void ThumbnailWorker::findRenderable(const QString &path, QSet<QString> *found)
+{
+    if (isInterruptionRequested())
+        return;
+
+    ThumbnailIndex batch;
+    QDir d(path);
+
+    foreach(const QFileInfo &fi, d.entryInfoList(AbstractThumbnailer::allNameFilters(), QDir::Files | QDir::Readable))
+    {
+        if (found->contains(fi.baseName()))
+            continue;
+        found->insert(fi.baseName());
+        batch.insert(fi.baseName(), ThumbnailSource(fi, true));
+    }
+
+    if (!batch.isEmpty())
+        emit indexReady(m_generation, batch, false);
+}
+
+void ThumbnailWorker::getThumbs(Metadata *m, QSet<QString> *found)
 {
     // local pictures
-    cacheThumbnails(m->path(), map);
+    findThumbnails(m->path(), found);
     // index
-    cacheThumbnails(m->path() + "/" + THUMBNAILS_DIR, map);
+    if (!findPackedThumbnails(m->path(), found))
+        findThumbnails(m->path() + "/" + THUMBNAILS_DIR, found);
     // now includes
 	foreach(Metadata *i, m->thumbnailIncludes())
     {
-        getThumbs(i, map);
+        getThumbs(i, found);
     }
 }
 
@@ -56,75 +277,402 @@ void ThumbnailWorker::getThumbs(Metadata *m, ThumbnailMap* map)
 ThumbnailManager::ThumbnailManager(QObject *parent)
     : QObject(parent),
       m_worker(0),
+      m_generation(0),
+      m_tier(ThumbnailCache::tier(Settings::get()->GUIThumbWidth)),
+      m_recent(RECENT_THUMBNAIL_DIRS),
       m_isLoading(true)
 {
-    qRegisterMetaType<ThumbnailMap>("ThumbnailMap");
+    qRegisterMetaType<ThumbnailIndex>("ThumbnailIndex");
+
+    connect(ThumbnailCache::get(), SIGNAL(loaded(QStringList)), this, SLOT(thumbnailsLoaded(QStringList)));
+    connect(PartCache::get(), SIGNAL(cleared(QString)), this, SLOT(forget(QString)));
+    connect(MetadataCache::get(), SIGNAL(cleared()), this, SLOT(forgetAll()));
 
     m_loading = QPixmap(":/gfx/image-loading.png");
 }
 
+ThumbnailManager::~ThumbnailManager()
+{
+    stopWorker();
+    resetQueue();
+}
+
 void ThumbnailManager::setPath(const QString &path)
 {
+    // remember the listing of the directory being left, its pixmaps
+    // stay in ThumbnailCache until they're evicted
+    if (!m_isLoading && !m_path.isEmpty())
+        m_recent.insert(m_path, new ThumbnailIndex(m_index));
+
+    // an open mapping would block replacing the pack on Windows shares
+    if (path != m_path)
+        ThumbnailPack::closeAll();
+
     m_path = path;
-    clear();
+
+    ThumbnailIndex *recent = m_recent.take(path);
+
+    if (!recent)
+    {
+        clear();
+        return;
+    }
+
+    // the model is reset right after, no need to announce the thumbnails
+    stopWorker();
+    resetQueue();
+    m_tier = ThumbnailCache::tier(Settings::get()->GUIThumbWidth);
+    setIndex(*recent);
+    m_isLoading = false;
+    delete recent;
 }
 
 void ThumbnailManager::clear()
 {
+    stopWorker();
+    resetQueue();
+    setIndex(ThumbnailIndex());
+    load();
+}
+
+void ThumbnailManager::forget(const QString &dir)
+{
+    m_recent.remove(dir);
+}
+
+void ThumbnailManager::forgetAll()
+{
+    m_recent.clear();
+}
+
+/*!
+ * The worker is not waited for, it may be stuck on a slow share.
+ * It is detached instead and deletes itself once it finishes,
+ * its results are dropped by the generation check in indexReady().
+ */
+void ThumbnailManager::stopWorker()
+{
+    m_generation++;
+
     if (m_worker)
     {
-        disconnect(m_worker, SIGNAL(dataReady(ThumbnailMap)), this, SLOT(dataReady(ThumbnailMap)));
+        disconnect(m_worker, SIGNAL(indexReady(int,ThumbnailIndex,bool)), this, SLOT(indexReady(int,ThumbnailIndex,bool)));
 
         m_worker->requestInterruption();
-        m_worker->wait();
-        m_worker->deleteLater();
+
+        connect(m_worker, SIGNAL(finished()), m_worker, SLOT(deleteLater()));
+
+        // it may have finished before the connection was made
+        if (m_worker->isFinished())
+            m_worker->deleteLater();
+
         m_worker = 0;
     }
-    m_cache.clear();
-    load();
+}
+
+void ThumbnailManager::resetQueue()
+{
+    auto cache = ThumbnailCache::get();
+
+    foreach (const QString &key, m_acquired)
+        cache->release(key);
+
+    if (!m_previewKey.isEmpty())
+        cache->release(m_previewKey);
+
+    // running loads finish and stay in the cache
+    m_acquired.clear();
+    m_previewKey.clear();
+    m_queue.clear();
+    m_queued.clear();
+    m_running.clear();
+}
+
+void ThumbnailManager::setIndex(const ThumbnailIndex &index)
+{
+    m_index.clear();
+    m_names.clear();
+    m_keys.clear();
+    addToIndex(index);
+}
+
+void ThumbnailManager::addToIndex(const ThumbnailIndex &index)
+{
+    ThumbnailIndex::const_iterator it = index.constBegin();
+
+    m_index.reserve(m_index.count() + index.count());
+    m_names.reserve(m_names.count() + index.count());
+    m_keys.reserve(m_keys.count() + index.count());
+
+    while (it != index.constEnd())
+    {
+        QString key = ThumbnailCache::key(it.value(), m_tier);
+
+        m_index.insert(it.key(), it.value());
+        m_names.insert(key, it.key());
+        m_keys.insert(it.key(), key);
+        ++it;
+    }
+}
+
+QString ThumbnailManager::cacheKey(const QString &baseName) const
+{
+    return m_keys.value(baseName);
 }
 
 void ThumbnailManager::load()
 {
-    m_worker = new ThumbnailWorker(m_path);
-    connect(m_worker, SIGNAL(dataReady(ThumbnailMap)), this, SLOT(dataReady(ThumbnailMap)));
+    qint64 evict = 0;
+
+    // evict the disk cache only if something was added to it
+    if (ThumbnailCache::get()->takeStoredCount() > 0)
+        evict = qint64(Settings::get()->GUIThumbCacheSize) * 1024 * 1024;
+
+    m_tier = ThumbnailCache::tier(Settings::get()->GUIThumbWidth);
+    m_worker = new ThumbnailWorker(m_path, m_tier, m_generation, evict);
+    connect(m_worker, SIGNAL(indexReady(int,ThumbnailIndex,bool)), this, SLOT(indexReady(int,ThumbnailIndex,bool)));
     m_isLoading = true;
     m_worker->start();
 }
 
-void ThumbnailManager::dataReady(const ThumbnailMap &data)
+void ThumbnailManager::indexReady(int generation, const ThumbnailIndex &index, bool complete)
 {
+    // a queued result of an abandoned worker
+    if (generation != m_generation)
+        return;
+
+    addToIndex(index);
+
+    if (!complete)
+    {
+        // thumbnails of the first listed directories are loaded
+        // while the includes are still being listed
+        emit indexUpdated();
+        return;
+    }
+
     m_isLoading = false;
-    m_cache = data;
-    emit updateModel();
+
+    // visible rows are repainted and request their thumbnails
+    emit loadingFinished();
+}
+
+void ThumbnailManager::request(const QList<QFileInfo> &files)
+{
+    auto cache = ThumbnailCache::get();
+    QSet<QString> acquired;
+
+    m_queue.clear();
+    m_queued.clear();
+
+    foreach (const QFileInfo &fi, files)
+    {
+        QString name = fi.baseName();
+
+        if (!m_index.contains(name))
+            continue;
+
+        QString key = cacheKey(name);
+        acquired.insert(key);
+
+        if (!cache->contains(key) && !isPending(name))
+            enqueue(name);
+    }
+
+    // acquire the new ones before releasing the old ones
+    foreach (const QString &key, acquired)
+    {
+        if (!m_acquired.contains(key))
+            cache->acquire(key);
+    }
+
+    foreach (const QString &key, m_acquired)
+    {
+        if (!acquired.contains(key))
+            cache->release(key);
+    }
+
+    m_acquired = acquired;
+
+    startJobs();
+}
+
+void ThumbnailManager::enqueue(const QString &baseName)
+{
+    m_queue << baseName;
+    m_queued.insert(baseName);
+}
+
+bool ThumbnailManager::isPending(const QString &baseName) const
+{
+    return m_queued.contains(baseName) || m_running.contains(cacheKey(baseName));
+}
+
+void ThumbnailManager::startJobs()
+{
+    // keep the queue in the manager, so it can be reordered and cancelled
+    auto cache = ThumbnailCache::get();
+    const int maxRunning = cache->maxLoading();
+
+    while (m_running.count() < maxRunning && !m_queue.isEmpty())
+    {
+        QString name = m_queue.takeFirst();
+        m_queued.remove(name);
+
+        QString key = cacheKey(name);
+
+        if (cache->contains(key))
+            continue;
+
+        m_running.insert(key);
+        cache->load(key, m_index[name], m_tier);
+    }
+}
+
+void ThumbnailManager::thumbnailsLoaded(const QStringList &keys)
+{
+    QStringList names;
+
+    foreach (const QString &key, keys)
+    {
+        // it may be loaded by another manager as well
+        m_running.remove(key);
+
+        if (key == m_previewKey)
+            emit previewReady(m_previewName);
+
+        if (m_names.contains(key))
+            names << m_names.values(key);
+    }
+
+    if (!names.isEmpty())
+        emit thumbnailsReady(names);
+
+    // a finished preview frees a slot as well
+    startJobs();
 }
 
 QPixmap ThumbnailManager::thumbnail(const QFileInfo &fi)
 {
-    if (m_isLoading)
-        return m_loading;
-    else if (m_cache.contains(fi.baseName()) && !m_cache[fi.baseName()].second.isNull())
-        return m_cache[fi.baseName()].second;
-    else
-        return QPixmap();
+    QString name = fi.baseName();
+
+    // it may be found in a directory not listed yet
+    if (!m_index.contains(name))
+        return m_isLoading ? m_loading : QPixmap();
+
+    auto cache = ThumbnailCache::get();
+    QString key = cacheKey(name);
+
+    if (cache->contains(key))
+        return scaled(key, cache->pixmap(key), Settings::get()->GUIThumbWidth);
+
+    // not requested by the view yet, e.g. the view was not scrolled
+    if (!isPending(name))
+    {
+        enqueue(name);
+        startJobs();
+    }
+
+    return m_loading;
 }
 
 QString ThumbnailManager::tooltip(const QFileInfo &fi)
 {
-    if (!m_cache[fi.baseName()].first.isEmpty())
+    // thumbnails are shown by preview()
+    if (m_index.contains(fi.baseName()))
+        return QString();
+
+    return tr("No thumbnail");
+}
+
+bool ThumbnailManager::hasThumbnail(const QFileInfo &fi) const
+{
+    return m_index.contains(fi.baseName());
+}
+
+QPixmap ThumbnailManager::preview(const QFileInfo &fi)
+{
+    QString name = fi.baseName();
+
+    if (!m_index.contains(name))
+        return QPixmap();
+
+    auto cache = ThumbnailCache::get();
+    const int width = Settings::get()->GUIPreviewWidth;
+    QString key = ThumbnailCache::key(m_index[name], ThumbnailCache::tier(width));
+
+    // keep only the last preview, it's loaded ahead of the thumbnails
+    if (key != m_previewKey)
     {
-        return QString("<img src=\"%1\" width=\"%2\">")
-               .arg(m_cache[fi.baseName()].first)
-               .arg(Settings::get()->GUIPreviewWidth);
+        cache->acquire(key);
+
+        if (!m_previewKey.isEmpty())
+            cache->release(m_previewKey);
+
+        m_previewKey = key;
+        m_previewName = name;
     }
-    return tr("No thumbnail");
+
+    if (cache->contains(key))
+        return scaled(key, cache->pixmap(key), width);
+
+    if (!m_running.contains(key))
+    {
+        m_running.insert(key);
+        cache->load(key, m_index[name], ThumbnailCache::tier(width));
+    }
+
+    return QPixmap();
 }
 
-QString ThumbnailManager::path(const QFileInfo &fi)
+bool ThumbnailManager::updateTier()
+{
+    const int tier = ThumbnailCache::tier(Settings::get()->GUIThumbWidth);
+
+    if (tier == m_tier)
+        return false;
+
+    // the listing stays, only the keys change
+    ThumbnailIndex index = m_index;
+
+    resetQueue();
+    m_tier = tier;
+    setIndex(index);
+
+    return true;
+}
+
+/*!
+ * Tiers are scaled to the requested width once, the result is kept
+ * in QPixmapCache.
+ */
+QPixmap ThumbnailManager::scaled(const QString &key, const QPixmap &pixmap, int width)
 {
-    if (!m_cache[fi.fileName()].first.isEmpty())
+    if (pixmap.width() <= width && pixmap.height() <= width)
+        return pixmap;
+
+    QString scaledKey = QString("%1@%2").arg(key).arg(width);
+    QPixmap ret;
+
+    if (!QPixmapCache::find(scaledKey, &ret))
     {
-        return m_cache[fi.fileName()].first;
+        ret = pixmap.scaled(width, width, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        QPixmapCache::insert(scaledKey, ret);
     }
-    return QString();
+
+    return ret;
+}
+
+QString ThumbnailManager::path(const QFileInfo &fi)
+{
+    if (!m_index.contains(fi.fileName()))
+        return QString();
+
+    const ThumbnailSource &source = m_index[fi.fileName()];
+
+    // rendered thumbnails are the part itself, packed ones may have no original
+    if (source.render || !QFile::exists(source.path))
+        return QString();
+
+    return source.path;
 }
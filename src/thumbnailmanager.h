@@ -4,61 +4,160 @@
 #include <QObject>
 #include <QFileInfo>
 #include <QPixmap>
+#include <QImage>
 #include <QThread>
+#include <QCache>
+#include <QSet>
 
 #include "metadata.h"
+#include "thumbnailcache.h"
 
-//! \brief Thumbnail map: baseName -> full path to the file (including the file name)
-typedef QHash<QString,QPair<QString,QPixmap> > ThumbnailMap;
+//! \brief Thumbnail index: baseName -> thumbnail source
+typedef QHash<QString,ThumbnailSource> ThumbnailIndex;
 
 
+/*!
+ * \brief Finds thumbnails of a directory
+ *
+ * Only the directories are listed here, the images are decoded
+ * on demand by ThumbnailJob. Thumbnails found in each listed directory
+ * are emitted right away, the last indexReady() has \a complete set.
+ */
 class ThumbnailWorker : public QThread
 {
     Q_OBJECT
 
 public:
-    ThumbnailWorker(const QString &path);
+    ThumbnailWorker(const QString &path, int size, int generation, qint64 evictCacheSize);
+    ~ThumbnailWorker();
+
+    //! Number of existing workers, abandoned ones included
+    static int count();
+
+    //! Decode image at \a path scaled to fit into \a size x \a size
+    static QImage decode(const QString &path, int size);
+    //! Load the thumbnail from a pack or ThumbnailDiskCache, or decode and store it
+    static QImage load(const ThumbnailSource &source, int size, bool *stored);
+    //! Render a part by its AbstractThumbnailer, or load it from ThumbnailDiskCache
+    static QImage render(const ThumbnailSource &source, int size, bool *stored);
+    //! Store \a img and its smaller tiers in ThumbnailDiskCache
+    static bool storeTiers(const ThumbnailSource &source, int size, const QImage &img);
 
 signals:
-    void dataReady(const ThumbnailMap &data);
+    void indexReady(int generation, const ThumbnailIndex &index, bool complete);
 
 protected:
     void run();
 
 private:
     QString m_path;
-
-    void cacheThumbnails(const QString &dirpath, ThumbnailMap* map);
-    void getThumbs(Metadata *m, ThumbnailMap* map);
+    int m_size;
+    int m_generation;
+    qint64 m_evictCacheSize;
+
+    void findThumbnails(const QString &dirpath, QSet<QString> *found);
+    //! Use THUMBNAILS_PACK of \a path if it's up to date, false otherwise
+    bool findPackedThumbnails(const QString &path, QSet<QString> *found);
+    //! Parts of \a path handled by an AbstractThumbnailer
+    void findRenderable(const QString &path, QSet<QString> *found);
+    void getThumbs(Metadata *m, QSet<QString> *found);
 };
 
+/*!
+ * \brief Thumbnails of FileModel's directory
+ *
+ * The directory and its thumbnail includes are listed in the background,
+ * then the thumbnails are loaded lazily: thumbnail() queues a missing
+ * thumbnail and request() reorders the queue by the distance from
+ * the viewport. Thumbnails no longer requested are dropped from the queue.
+ *
+ * Pixmaps are stored in the process-wide ThumbnailCache, the manager
+ * only maps base names to cache keys. Thumbnails are loaded in the tier
+ * of GUIThumbWidth and previews in the tier of GUIPreviewWidth, both are
+ * scaled to the exact width when displayed. Requested thumbnails are acquired
+ * in the cache, the others can be evicted and are reloaded
+ * (from ThumbnailDiskCache) when needed again.
+ */
 class ThumbnailManager : public QObject
 {
     Q_OBJECT
 public:
     explicit ThumbnailManager(QObject *parent = 0);
+    ~ThumbnailManager();
 
     QPixmap thumbnail(const QFileInfo &fi);
     QString tooltip(const QFileInfo &fi);
+    //! Image file of the thumbnail, empty for rendered thumbnails or packed ones without the original
     QString path(const QFileInfo &fi);
 
+    bool hasThumbnail(const QFileInfo &fi) const;
+    //! Thumbnail in GUIPreviewWidth, null while it's being loaded
+    QPixmap preview(const QFileInfo &fi);
+    //! Switch to the tier of the current GUIThumbWidth, true if it changed
+    bool updateTier();
+
+    //! Load thumbnails of \a files in this order, cancel all other pending ones
+    void request(const QList<QFileInfo> &files);
+
 signals:
-    void updateModel();
+    //! Thumbnails for given base names are available
+    void thumbnailsReady(const QStringList &baseNames);
+    //! More thumbnails were found, they can be requested now
+    void indexUpdated();
+    //! Listing is done, parts without a thumbnail will not get one
+    void loadingFinished();
+    //! Preview requested by preview() was loaded
+    void previewReady(const QString &baseName);
 
 public slots:
     void setPath(const QString &path);
     void clear();
-    void dataReady(const ThumbnailMap &data);
+    void indexReady(int generation, const ThumbnailIndex &index, bool complete);
+    //! Drop remembered thumbnails of \a dir
+    void forget(const QString &dir);
+    void forgetAll();
+
+private slots:
+    void thumbnailsLoaded(const QStringList &keys);
 
 private:
     ThumbnailWorker *m_worker;
+    //! Increased with every listing, results of abandoned workers are dropped
+    int m_generation;
+    //! ThumbnailCache tier of the thumbnails
+    int m_tier;
 
     QString m_path;
     QPixmap m_loading;
-    ThumbnailMap m_cache;
+    ThumbnailIndex m_index;
+    //! ThumbnailCache key -> base names using it
+    QMultiHash<QString,QString> m_names;
+    //! base name -> ThumbnailCache key
+    QHash<QString,QString> m_keys;
+    //! base names waiting for a free thread, the most important first
+    QList<QString> m_queue;
+    QSet<QString> m_queued;
+    //! keys being loaded on our behalf
+    QSet<QString> m_running;
+    //! keys acquired in ThumbnailCache
+    QSet<QString> m_acquired;
+    //! the last requested preview, acquired as well
+    QString m_previewKey;
+    QString m_previewName;
+    //! Listings of recently visited directories
+    QCache<QString, ThumbnailIndex> m_recent;
     bool m_isLoading;
 
     void load();
+    void stopWorker();
+    void resetQueue();
+    void setIndex(const ThumbnailIndex &index);
+    void addToIndex(const ThumbnailIndex &index);
+    QString cacheKey(const QString &baseName) const;
+    void enqueue(const QString &baseName);
+    void startJobs();
+    bool isPending(const QString &baseName) const;
+    QPixmap scaled(const QString &key, const QPixmap &pixmap, int width);
 };
 
 #endif // THUMBNAILMANAGER_H
@@ -0,0 +1,328 @@
+#include <QSaveFile>
+#include <QMutex>
+#include <QHash>
+#include <algorithm>
+#include <cstring>
+
+#include "thumbnailpack.h"
+
+#define PACK_MAGIC "ZCPK"
+#define PACK_VERSION 1
+// Number of packs kept open by open()
+#define PACK_OPEN_MAX 32
+
+
+ThumbnailPack::ThumbnailPack(const QString &path)
+	: m_file(path),
+	  m_data(0),
+	  m_size(0),
+	  m_header(0),
+	  m_sizes(0),
+	  m_entries(0),
+	  m_strings(0),
+	  m_stringsLength(0)
+{
+	if (!m_file.open(QIODevice::ReadOnly))
+		return;
+
+	m_modified = m_file.fileTime(QFileDevice::FileModificationTime);
+	m_size = m_file.size();
+	m_data = m_file.map(0, m_size);
+
+	if (m_data && !validate())
+	{
+		m_file.unmap((uchar*) m_data);
+		m_data = 0;
+	}
+}
+
+ThumbnailPack::~ThumbnailPack()
+{
+	if (m_data)
+		m_file.unmap((uchar*) m_data);
+}
+
+// Packs opened by open(), shared by all threads
+static QMutex openMutex;
+static QHash<QString, QSharedPointer<ThumbnailPack> > openPacks;
+
+QSharedPointer<ThumbnailPack> ThumbnailPack::open(const QString &path, qint64 modified)
+{
+	QMutexLocker locker(&openMutex);
+	QSharedPointer<ThumbnailPack> pack = openPacks.value(path);
+
+	if (pack && pack->lastModified().toMSecsSinceEpoch() == modified)
+		return pack;
+
+	// images of dropped packs can still be in use, the shared pointer
+	// keeps them mapped until the last user is done
+	if (openPacks.count() >= PACK_OPEN_MAX)
+		openPacks.clear();
+
+	pack = QSharedPointer<ThumbnailPack>(new ThumbnailPack(path));
+	openPacks.insert(path, pack);
+
+	return pack;
+}
+
+void ThumbnailPack::closeAll()
+{
+	QMutexLocker locker(&openMutex);
+	openPacks.clear();
+}
+
+bool ThumbnailPack::write(const QString &path, const QList<int> &sizes, QList<Item> items)
+{
+	if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN)
+		return false;
+
+	std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+		return a.baseName < b.baseName;
+	});
+
+	Header h;
+	memcpy(h.magic, PACK_MAGIC, 4);
+	h.version = PACK_VERSION;
+	h.sizeCount = sizes.count();
+	h.entryCount = items.count();
+	h.reserved = 0;
+
+	// strings
+	QString strings;
+	QList<EntryHeader> entries;
+
+	foreach (const Item &item, items)
+	{
+		if (item.images.count() != sizes.count())
+			return false;
+
+		EntryHeader e;
+		e.nameOffset = strings.size();
+		e.nameLength = item.baseName.size();
+		strings += item.baseName;
+		e.fileNameOffset = strings.size();
+		e.fileNameLength = item.fileName.size();
+		strings += item.fileName;
+
+		entries << e;
+	}
+
+	const quint64 entriesOffset = sizeof(Header) + ((sizes.count() * 4 + 7) & ~7);
+	const quint64 entrySize = sizeof(EntryHeader) + sizes.count() * sizeof(ImageRecord);
+	h.stringsOffset = entriesOffset + entrySize * items.count();
+
+	quint64 offset = (h.stringsOffset + strings.size() * 2 + 15) & ~15;
+
+	// image records and converted images
+	QList<ImageRecord> records;
+	QList<QImage> images;
+
+	foreach (const Item &item, items)
+	{
+		foreach (const QImage &src, item.images)
+		{
+			QImage img = src.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+			ImageRecord r;
+			r.width = img.width();
+			r.height = img.height();
+			r.offset = offset;
+
+			offset = (offset + quint64(r.width) * r.height * 4 + 15) & ~15;
+
+			records << r;
+			images << img;
+		}
+	}
+
+	QSaveFile f(path);
+
+	if (!f.open(QIODevice::WriteOnly))
+		return false;
+
+	f.write((const char*) &h, sizeof(h));
+
+	foreach (int size, sizes)
+	{
+		quint32 s = size;
+		f.write((const char*) &s, sizeof(s));
+	}
+
+	f.write(QByteArray(entriesOffset - f.pos(), '\0'));
+
+	for (int i = 0; i < entries.count(); i++)
+	{
+		f.write((const char*) &entries[i], sizeof(EntryHeader));
+
+		for (int j = 0; j < sizes.count(); j++)
+			f.write((const char*) &records[i * sizes.count() + j], sizeof(ImageRecord));
+	}
+
+	f.write((const char*) strings.utf16(), strings.size() * 2);
+
+	for (int i = 0; i < images.count(); i++)
+	{
+		f.write(QByteArray(records[i].offset - f.pos(), '\0'));
+
+		const QImage &img = images[i];
+
+		for (int y = 0; y < img.height(); y++)
+			f.write((const char*) img.constScanLine(y), img.width() * 4);
+	}
+
+	return f.commit();
+}
+
+bool ThumbnailPack::isValid() const
+{
+	return m_data != 0;
+}
+
+QDateTime ThumbnailPack::lastModified() const
+{
+	return m_modified;
+}
+
+bool ThumbnailPack::hasSize(int size) const
+{
+	if (!isValid())
+		return false;
+
+	for (quint32 i = 0; i < m_header->sizeCount; i++)
+	{
+		if (m_sizes[i] == quint32(size))
+			return true;
+	}
+
+	return false;
+}
+
+QList<int> ThumbnailPack::sizes() const
+{
+	QList<int> ret;
+
+	if (!isValid())
+		return ret;
+
+	for (quint32 i = 0; i < m_header->sizeCount; i++)
+		ret << m_sizes[i];
+
+	return ret;
+}
+
+int ThumbnailPack::count() const
+{
+	return isValid() ? m_header->entryCount : 0;
+}
+
+QString ThumbnailPack::baseName(int i) const
+{
+	const EntryHeader *e = entry(i);
+	return string(e->nameOffset, e->nameLength);
+}
+
+QString ThumbnailPack::fileName(int i) const
+{
+	const EntryHeader *e = entry(i);
+	return string(e->fileNameOffset, e->fileNameLength);
+}
+
+int ThumbnailPack::find(const QString &baseName) const
+{
+	int first = 0;
+	int last = count();
+
+	// entries are sorted by base name
+	while (first < last)
+	{
+		const int mid = (first + last) / 2;
+		const EntryHeader *e = entry(mid);
+		const int cmp = QString::compare(
+			QString::fromRawData(m_strings + e->nameOffset, e->nameLength),
+			baseName
+		);
+
+		if (cmp == 0)
+			return mid;
+		else if (cmp < 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	return -1;
+}
+
+QImage ThumbnailPack::image(int i, int size) const
+{
+	if (i < 0 || i >= count())
+		return QImage();
+
+	const ImageRecord *records = (const ImageRecord*) (((const uchar*) entry(i)) + sizeof(EntryHeader));
+
+	for (quint32 s = 0; s < m_header->sizeCount; s++)
+	{
+		if (m_sizes[s] != quint32(size))
+			continue;
+
+		const ImageRecord &r = records[s];
+
+		if (r.width == 0 || r.height == 0
+				|| r.offset + quint64(r.width) * r.height * 4 > quint64(m_size))
+			return QImage();
+
+		return QImage(m_data + r.offset, r.width, r.height, r.width * 4,
+					  QImage::Format_ARGB32_Premultiplied);
+	}
+
+	return QImage();
+}
+
+bool ThumbnailPack::validate()
+{
+	if (Q_BYTE_ORDER != Q_LITTLE_ENDIAN || m_size < qint64(sizeof(Header)))
+		return false;
+
+	m_header = (const Header*) m_data;
+
+	if (memcmp(m_header->magic, PACK_MAGIC, 4) != 0 || m_header->version != PACK_VERSION)
+		return false;
+
+	const quint64 entriesOffset = sizeof(Header) + ((m_header->sizeCount * 4 + 7) & ~7);
+	const quint64 entriesEnd = entriesOffset + quint64(entrySize()) * m_header->entryCount;
+
+	if (m_header->sizeCount > 16 || entriesEnd > m_header->stringsOffset
+			|| m_header->stringsOffset > quint64(m_size))
+		return false;
+
+	m_sizes = (const quint32*) (m_data + sizeof(Header));
+	m_entries = m_data + entriesOffset;
+	m_strings = (const QChar*) (m_data + m_header->stringsOffset);
+	m_stringsLength = (m_size - m_header->stringsOffset) / 2;
+
+	for (quint32 i = 0; i < m_header->entryCount; i++)
+	{
+		const EntryHeader *e = entry(i);
+
+		if (quint64(e->nameOffset) + e->nameLength > quint64(m_stringsLength)
+				|| quint64(e->fileNameOffset) + e->fileNameLength > quint64(m_stringsLength))
+			return false;
+	}
+
+	return true;
+}
+
+int ThumbnailPack::entrySize() const
+{
+	return sizeof(EntryHeader) + m_header->sizeCount * sizeof(ImageRecord);
+}
+
+const ThumbnailPack::EntryHeader *ThumbnailPack::entry(int i) const
+{
+	return (const EntryHeader*) (m_entries + qint64(i) * entrySize());
+}
+
+QString ThumbnailPack::string(quint32 offset, quint32 length) const
+{
+	return QString(m_strings + offset, length);
+}
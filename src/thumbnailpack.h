@@ -0,0 +1,106 @@
+#ifndef THUMBNAILPACK_H
+#define THUMBNAILPACK_H
+
+#include <QString>
+#include <QStringList>
+#include <QImage>
+#include <QFile>
+#include <QDateTime>
+#include <QSharedPointer>
+
+/*!
+ * \brief Pre-scaled thumbnails of a directory packed in one file
+ *
+ * Opening and decoding thousands of small images on a network share
+ * costs thousands of round trips. The pack (THUMBNAILS_PACK) contains
+ * all thumbnails of THUMBNAILS_DIR scaled to one or more widths, stored
+ * as raw premultiplied ARGB32 pixels. It is memory mapped, so a thumbnail
+ * is a QImage over the mapped memory without any decoding.
+ *
+ * Layout, all numbers in little endian:
+ *
+ *   header   "ZCPK", version, size count, entry count, strings offset
+ *   sizes    thumbnail widths, one u32 each
+ *   entries  sorted by base name: name and file name (offset and length
+ *            in the string table), then width, height and pixel offset
+ *            for each size
+ *   strings  UTF-16 names
+ *   pixels   scan lines of all images, each image 16 bytes aligned
+ */
+class ThumbnailPack
+{
+public:
+	//! Thumbnail of one part, used by write()
+	struct Item {
+		QString baseName;
+		//! file name of the source image in THUMBNAILS_DIR
+		QString fileName;
+		//! images in the order of sizes given to write()
+		QList<QImage> images;
+	};
+
+	explicit ThumbnailPack(const QString &path);
+	~ThumbnailPack();
+
+	/*!
+	 * Opened pack shared by all threads. It's reopened when its time differs
+	 * from \a modified, the time seen when the directory was listed, so that
+	 * the file is not stat'ed for every thumbnail.
+	 */
+	static QSharedPointer<ThumbnailPack> open(const QString &path, qint64 modified);
+	//! Forget opened packs, they're unmapped once their images are not used
+	static void closeAll();
+	static bool write(const QString &path, const QList<int> &sizes, QList<Item> items);
+
+	bool isValid() const;
+	QDateTime lastModified() const;
+	bool hasSize(int size) const;
+	QList<int> sizes() const;
+	int count() const;
+	QString baseName(int entry) const;
+	QString fileName(int entry) const;
+	//! Entry of \a baseName, -1 if not packed
+	int find(const QString &baseName) const;
+	//! Image over the mapped memory, valid only while the pack exists
+	QImage image(int entry, int size) const;
+
+private:
+	struct Header {
+		char magic[4];
+		quint32 version;
+		quint32 sizeCount;
+		quint32 entryCount;
+		quint64 stringsOffset;
+		quint64 reserved;
+	};
+
+	struct EntryHeader {
+		quint32 nameOffset;
+		quint32 nameLength;
+		quint32 fileNameOffset;
+		quint32 fileNameLength;
+	};
+
+	struct ImageRecord {
+		quint32 width;
+		quint32 height;
+		quint64 offset;
+	};
+
+	QFile m_file;
+	QDateTime m_modified;
+	const uchar *m_data;
+	qint64 m_size;
+	const Header *m_header;
+	const quint32 *m_sizes;
+	const uchar *m_entries;
+	const QChar *m_strings;
+	qint64 m_stringsLength;
+
+	bool validate();
+	int entrySize() const;
+	const EntryHeader *entry(int i) const;
+	QString string(quint32 offset, quint32 length) const;
+};
+
+#endif // THUMBNAILPACK_H
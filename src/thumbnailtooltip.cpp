@@ -0,0 +1,96 @@
+#include <QAbstractItemView>
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QCursor>
+#include <QToolTip>
+#include <QTimer>
+
+#include "thumbnailtooltip.h"
+
+// How often the cursor position is checked, in ms
+#define TOOLTIP_CHECK_INTERVAL 100
+// Offset of the tooltip from the cursor
+#define TOOLTIP_OFFSET 16
+
+
+ThumbnailToolTip::ThumbnailToolTip(QAbstractItemView *view)
+	: QLabel(view, Qt::ToolTip | Qt::BypassGraphicsProxyWidget),
+	  m_view(view)
+{
+	setForegroundRole(QPalette::ToolTipText);
+	setBackgroundRole(QPalette::ToolTipBase);
+	setPalette(QToolTip::palette());
+	setAutoFillBackground(true);
+	setFrameStyle(QFrame::StyledPanel);
+	setMargin(2);
+	setAlignment(Qt::AlignCenter);
+
+	m_timer = new QTimer(this);
+	m_timer->setInterval(TOOLTIP_CHECK_INTERVAL);
+
+	connect(m_timer, SIGNAL(timeout()), this, SLOT(checkCursor()));
+}
+
+void ThumbnailToolTip::showPreview(const QModelIndex &index, const QPoint &globalPos, const QPixmap &pixmap)
+{
+	m_index = index;
+	setPreview(pixmap);
+
+	// keep it on the screen
+	QRect screen = QApplication::desktop()->availableGeometry(globalPos);
+	QPoint pos = globalPos + QPoint(TOOLTIP_OFFSET, TOOLTIP_OFFSET);
+
+	if (pos.x() + width() > screen.right())
+		pos.setX(qMax(screen.left(), globalPos.x() - TOOLTIP_OFFSET - width()));
+
+	if (pos.y() + height() > screen.bottom())
+		pos.setY(qMax(screen.top(), globalPos.y() - TOOLTIP_OFFSET - height()));
+
+	move(pos);
+	show();
+	m_timer->start();
+}
+
+void ThumbnailToolTip::updatePreview(const QModelIndex &index, const QPixmap &pixmap)
+{
+	if (!isVisible() || index != m_index)
+		return;
+
+	QPoint center = geometry().center();
+	setPreview(pixmap);
+
+	// grow around the same point
+	QRect r = geometry();
+	r.moveCenter(center);
+	move(r.topLeft());
+}
+
+QModelIndex ThumbnailToolTip::index() const
+{
+	return m_index;
+}
+
+void ThumbnailToolTip::hidePreview()
+{
+	m_timer->stop();
+	m_index = QModelIndex();
+	hide();
+}
+
+void ThumbnailToolTip::checkCursor()
+{
+	QPoint pos = m_view->viewport()->mapFromGlobal(QCursor::pos());
+
+	if (!m_index.isValid() || !m_view->isVisible() || m_view->indexAt(pos) != m_index)
+		hidePreview();
+}
+
+void ThumbnailToolTip::setPreview(const QPixmap &pixmap)
+{
+	if (pixmap.isNull())
+		setText(tr("Loading preview..."));
+	else
+		setPixmap(pixmap);
+
+	adjustSize();
+}
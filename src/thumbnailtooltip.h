@@ -0,0 +1,47 @@
+#ifndef THUMBNAILTOOLTIP_H
+#define THUMBNAILTOOLTIP_H
+
+#include <QLabel>
+#include <QPersistentModelIndex>
+
+class QAbstractItemView;
+class QTimer;
+
+/*!
+ * \brief Tooltip showing a thumbnail preview from memory
+ *
+ * A rich text tooltip with an image would make the tooltip renderer
+ * decode the original image from the share on every hover. This one
+ * shows a QPixmap given by the view, e.g. from ThumbnailCache.
+ *
+ * It hides itself once the cursor leaves the item it was shown for.
+ * The item is kept as a QPersistentModelIndex, so sorting or filtering
+ * the proxy never makes it refer to another row.
+ */
+class ThumbnailToolTip : public QLabel
+{
+	Q_OBJECT
+public:
+	explicit ThumbnailToolTip(QAbstractItemView *view);
+
+	//! Show \a pixmap for \a index, a loading text if it's null
+	void showPreview(const QModelIndex &index, const QPoint &globalPos, const QPixmap &pixmap);
+	//! Replace the pixmap if the tooltip is shown for \a index
+	void updatePreview(const QModelIndex &index, const QPixmap &pixmap);
+	QModelIndex index() const;
+
+public slots:
+	void hidePreview();
+
+private slots:
+	void checkCursor();
+
+private:
+	QAbstractItemView *m_view;
+	QPersistentModelIndex m_index;
+	QTimer *m_timer;
+
+	void setPreview(const QPixmap &pixmap);
+};
+
+#endif // THUMBNAILTOOLTIP_H
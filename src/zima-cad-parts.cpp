@@ -24,6 +24,7 @@
 #include <QLocale>
 #include "mainwindow.h"
 #include "settings.h"
+#include "iconcache.h"
 
 /**
 \mainpage ZIMA-CAD-Parts Developer Documentation
@@ -60,6 +61,8 @@ int main(int argc, char *argv[])
 
 	QApplication a(argc, argv);
 
+	IconCache::get()->warmUp();
+
 	QTranslator translator;
 	QString lang = Settings::get()->getCurrentLanguageCode();
 
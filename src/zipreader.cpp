@@ -0,0 +1,219 @@
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+#include "zipreader.h"
+
+#define ZIP_EOCD_SIGNATURE 0x06054b50
+#define ZIP_CENTRAL_SIGNATURE 0x02014b50
+#define ZIP_LOCAL_SIGNATURE 0x04034b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CENTRAL_SIZE 46
+#define ZIP_LOCAL_SIZE 30
+#define ZIP_MAX_COMMENT 0xffff
+// Compression methods
+#define ZIP_STORED 0
+#define ZIP_DEFLATED 8
+// Flags
+#define ZIP_ENCRYPTED 0x1
+#define ZIP_UTF8 0x800
+
+
+static quint32 le32(const char *p)
+{
+	return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(p));
+}
+
+static quint16 le16(const char *p)
+{
+	return qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(p));
+}
+
+
+ZipReader::ZipReader(const QString &path)
+	: m_file(path),
+	  m_valid(false)
+{
+	if (m_file.open(QIODevice::ReadOnly))
+		m_valid = readCentralDirectory();
+}
+
+bool ZipReader::isValid() const
+{
+	return m_valid;
+}
+
+int ZipReader::find(const QString &name) const
+{
+	for (int i = 0; i < m_entries.count(); i++)
+	{
+		if (m_entries[i].name.compare(name, Qt::CaseInsensitive) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+int ZipReader::findPrefix(const QString &prefix) const
+{
+	for (int i = 0; i < m_entries.count(); i++)
+	{
+		if (m_entries[i].name.startsWith(prefix, Qt::CaseInsensitive))
+			return i;
+	}
+
+	return -1;
+}
+
+QByteArray ZipReader::read(int entry, qint64 maxSize)
+{
+	if (!m_valid || entry < 0 || entry >= m_entries.count())
+		return QByteArray();
+
+	const Entry &e = m_entries[entry];
+
+	if (e.size > maxSize || e.compressedSize > maxSize || (e.flags & ZIP_ENCRYPTED))
+		return QByteArray();
+
+	if (e.method != ZIP_STORED && e.method != ZIP_DEFLATED)
+		return QByteArray();
+
+	// name and extra field lengths of the local header may differ from the central one
+	char local[ZIP_LOCAL_SIZE];
+
+	if (!m_file.seek(e.offset) || m_file.read(local, ZIP_LOCAL_SIZE) != ZIP_LOCAL_SIZE)
+		return QByteArray();
+
+	if (le32(local) != ZIP_LOCAL_SIGNATURE)
+		return QByteArray();
+
+	if (!m_file.seek(qint64(e.offset) + ZIP_LOCAL_SIZE + le16(local + 26) + le16(local + 28)))
+		return QByteArray();
+
+	QByteArray compressed = m_file.read(e.compressedSize);
+
+	if (compressed.size() != int(e.compressedSize))
+		return QByteArray();
+
+	QByteArray ret;
+
+	if (e.method == ZIP_STORED)
+	{
+		ret = compressed;
+
+	} else {
+		ret.resize(e.size);
+
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+
+		// negative window bits for raw deflate data without zlib header
+		if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+			return QByteArray();
+
+		zs.next_in = reinterpret_cast<Bytef*>(compressed.data());
+		zs.avail_in = compressed.size();
+		zs.next_out = reinterpret_cast<Bytef*>(ret.data());
+		zs.avail_out = ret.size();
+
+		const int status = inflate(&zs, Z_FINISH);
+		const uLong total = zs.total_out;
+		inflateEnd(&zs);
+
+		if (status != Z_STREAM_END || total != e.size)
+			return QByteArray();
+	}
+
+	if (crc32(0, reinterpret_cast<const Bytef*>(ret.constData()), ret.size()) != e.crc)
+		return QByteArray();
+
+	return ret;
+}
+
+bool ZipReader::readCentralDirectory()
+{
+	const qint64 fileSize = m_file.size();
+
+	if (fileSize < ZIP_EOCD_SIZE)
+		return false;
+
+	// the end of central directory record is followed only by a comment
+	const qint64 tailSize = qMin<qint64>(fileSize, ZIP_EOCD_SIZE + ZIP_MAX_COMMENT);
+
+	if (!m_file.seek(fileSize - tailSize))
+		return false;
+
+	const QByteArray tail = m_file.read(tailSize);
+
+	if (tail.size() != tailSize)
+		return false;
+
+	int eocd = -1;
+
+	for (int i = tail.size() - ZIP_EOCD_SIZE; i >= 0; i--)
+	{
+		if (le32(tail.constData() + i) == ZIP_EOCD_SIGNATURE)
+		{
+			eocd = i;
+			break;
+		}
+	}
+
+	if (eocd == -1)
+		return false;
+
+	const char *p = tail.constData() + eocd;
+	const quint16 count = le16(p + 10);
+	const quint32 cdSize = le32(p + 12);
+	const quint32 cdOffset = le32(p + 16);
+
+	if (qint64(cdOffset) + cdSize > fileSize || !m_file.seek(cdOffset))
+		return false;
+
+	const QByteArray cd = m_file.read(cdSize);
+
+	if (cd.size() != int(cdSize))
+		return false;
+
+	int pos = 0;
+	m_entries.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (pos + ZIP_CENTRAL_SIZE > cd.size())
+			return false;
+
+		const char *h = cd.constData() + pos;
+
+		if (le32(h) != ZIP_CENTRAL_SIGNATURE)
+			return false;
+
+		const int nameLength = le16(h + 28);
+		const int next = pos + ZIP_CENTRAL_SIZE + nameLength + le16(h + 30) + le16(h + 32);
+
+		if (next > cd.size())
+			return false;
+
+		Entry e;
+		e.flags = le16(h + 8);
+		e.method = le16(h + 10);
+		e.crc = le32(h + 16);
+		e.compressedSize = le32(h + 20);
+		e.size = le32(h + 24);
+		e.offset = le32(h + 42);
+
+		if (e.flags & ZIP_UTF8)
+			e.name = QString::fromUtf8(h + ZIP_CENTRAL_SIZE, nameLength);
+		else
+			e.name = QString::fromLatin1(h + ZIP_CENTRAL_SIZE, nameLength);
+
+		m_entries << e;
+		pos = next;
+	}
+
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef ZIPREADER_H
+#define ZIPREADER_H
+
+#include <QFile>
+#include <QVector>
+#include <QByteArray>
+
+/*!
+ * \brief Read-only access to single entries of a ZIP archive
+ *
+ * Only the end of the file with the central directory is read when
+ * opening the archive. Reading an entry then costs two more reads,
+ * one of its local header and one of its data. Stored and deflated
+ * entries are supported, ZIP64 and encryption are not.
+ */
+class ZipReader
+{
+public:
+	explicit ZipReader(const QString &path);
+
+	bool isValid() const;
+	//! Entry named \a name (case insensitive), -1 if not found
+	int find(const QString &name) const;
+	//! First entry whose name starts with \a prefix (case insensitive), -1 if not found
+	int findPrefix(const QString &prefix) const;
+	//! Uncompressed contents of \a entry, null if it's larger than \a maxSize or damaged
+	QByteArray read(int entry, qint64 maxSize);
+
+private:
+	struct Entry {
+		QString name;
+		quint16 flags;
+		quint16 method;
+		quint32 crc;
+		quint32 compressedSize;
+		quint32 size;
+		quint32 offset;
+	};
+
+	QFile m_file;
+	bool m_valid;
+	QVector<Entry> m_entries;
+
+	bool readCentralDirectory();
+};
+
+#endif // ZIPREADER_H
@@ -0,0 +1,18 @@
+# -------------------------------------------------
+# Microbenchmark of ImageScaler against QImage::scaled()
+# -------------------------------------------------
+QT += gui
+QT -= network
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = imagescaler-bench
+TEMPLATE = app
+
+ROOT = ../..
+
+INCLUDEPATH += $$ROOT/src
+
+SOURCES += main.cpp \
+    $$ROOT/src/imagescaler.cpp
+
+HEADERS += $$ROOT/src/imagescaler.h
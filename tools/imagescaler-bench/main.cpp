@@ -0,0 +1,133 @@
+/*
+  ZIMA-CAD-Parts
+  http://www.zima-construction.cz/software/ZIMA-CAD-Parts
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QTextStream>
+#include <functional>
+
+#include "imagescaler.h"
+
+// Size of the generated drawing when no image is given
+#define SOURCE_WIDTH 4000
+#define SOURCE_HEIGHT 3000
+// Each case runs at least this long
+#define MIN_DURATION_MS 500
+
+
+/*!
+ * Line art similar to CAD previews: one pixel lines on white,
+ * the worst case for nearest neighbour scaling.
+ */
+static QImage drawing()
+{
+	QImage img(SOURCE_WIDTH, SOURCE_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+	img.fill(Qt::white);
+
+	QPainter p(&img);
+	p.setPen(QPen(Qt::black, 1));
+
+	for (int i = 0; i < 200; i++)
+	{
+		p.drawLine(0, i * 15, SOURCE_WIDTH, SOURCE_HEIGHT - i * 15);
+		p.drawEllipse(QPoint(SOURCE_WIDTH / 2, SOURCE_HEIGHT / 2), i * 10, i * 7);
+	}
+
+	return img;
+}
+
+//! Average milliseconds of one call of \a fn
+static double measure(std::function<QImage()> fn)
+{
+	QElapsedTimer timer;
+	int iterations = 0;
+
+	timer.start();
+
+	do {
+		fn();
+		iterations++;
+	} while (timer.elapsed() < MIN_DURATION_MS);
+
+	return double(timer.nsecsElapsed()) / iterations / 1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+	QGuiApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Compares ImageScaler with QImage::scaled().");
+	parser.addHelpOption();
+	parser.addPositionalArgument("image", "Source image, a generated drawing by default.", "[image]");
+
+	QCommandLineOption sizesOpt(QStringList() << "s" << "sizes", "Comma separated target widths.", "sizes", "32,64,128,512");
+	parser.addOption(sizesOpt);
+	parser.process(a);
+
+	QTextStream out(stdout);
+	QImage src;
+
+	if (parser.positionalArguments().isEmpty())
+		src = drawing();
+	else
+		src = QImage(parser.positionalArguments().first());
+
+	if (src.isNull())
+	{
+		QTextStream(stderr) << "imagescaler-bench: cannot load the image" << endl;
+		return 1;
+	}
+
+	src = src.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+	out << "source " << src.width() << "x" << src.height()
+		<< ", best kernel " << ImageScaler::kernelName(ImageScaler::bestKernel()) << endl;
+
+	foreach (const QString &s, parser.value(sizesOpt).split(',', QString::SkipEmptyParts))
+	{
+		const QSize size = src.size().scaled(s.toInt(), s.toInt(), Qt::KeepAspectRatio);
+
+		out << endl << size.width() << "x" << size.height() << endl;
+
+		out << "  QImage fast      " << QString::number(measure([&]() {
+			return src.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+		}), 'f', 3) << " ms" << endl;
+
+		out << "  QImage smooth    " << QString::number(measure([&]() {
+			return src.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		}), 'f', 3) << " ms" << endl;
+
+		for (int k = ImageScaler::Scalar; k < ImageScaler::KernelCount; k++)
+		{
+			ImageScaler::Kernel kernel = ImageScaler::Kernel(k);
+
+			if (!ImageScaler::isSupported(kernel))
+				continue;
+
+			out << "  ImageScaler " << ImageScaler::kernelName(kernel).leftJustified(7)
+				<< QString::number(measure([&]() {
+					return ImageScaler::scaled(src, size.width(), size.height(), kernel);
+				}), 'f', 3) << " ms" << endl;
+		}
+	}
+
+	return 0;
+}
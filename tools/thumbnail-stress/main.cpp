@@ -0,0 +1,158 @@
+/*
+  ZIMA-CAD-Parts
+  http://www.zima-construction.cz/software/ZIMA-CAD-Parts
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDir>
+#include <QTextStream>
+
+#include "thumbnailmanager.h"
+#include "thumbnailcache.h"
+
+// Directory switches per second
+#define SWITCH_RATE 100
+// Number of directory switches
+#define SWITCH_COUNT 1000
+// Time abandoned workers have to finish after the last switch
+#define DRAIN_TIMEOUT_MS 30000
+
+
+/*!
+ * Switches ThumbnailManager between the given directories at SWITCH_RATE
+ * and requests thumbnails of each as soon as they're listed. Afterwards,
+ * all abandoned ThumbnailWorkers must be deleted and all thumbnails
+ * acquired in ThumbnailCache released.
+ */
+int main(int argc, char *argv[])
+{
+	QApplication a(argc, argv);
+
+	// use the application settings, e.g. the thumbnail width
+	QCoreApplication::setOrganizationName("ZIMA-Construction");
+	QCoreApplication::setOrganizationDomain("zima-contruction.cz");
+	QCoreApplication::setApplicationName("ZIMA-CAD-Parts");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Switches ThumbnailManager between directories and checks it cleans up.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("directories", "Directories with thumbnails, at least two.", "<directory>...");
+
+	QCommandLineOption rateOpt(QStringList() << "r" << "rate", "Directory switches per second.", "rate", QString::number(SWITCH_RATE));
+	QCommandLineOption countOpt(QStringList() << "n" << "count", "Number of directory switches.", "count", QString::number(SWITCH_COUNT));
+	parser.addOption(rateOpt);
+	parser.addOption(countOpt);
+	parser.process(a);
+
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+	QStringList dirs;
+
+	foreach (const QString &dir, parser.positionalArguments())
+		dirs << QDir(dir).absolutePath();
+
+	if (dirs.count() < 2)
+	{
+		err << "thumbnail-stress: give at least two directories" << endl;
+		return 1;
+	}
+
+	const int rate = qMax(parser.value(rateOpt).toInt(), 1);
+	const int count = qMax(parser.value(countOpt).toInt(), 1);
+
+	QHash<QString, QList<QFileInfo> > files;
+
+	foreach (const QString &dir, dirs)
+		files[dir] = QDir(dir).entryInfoList(QDir::Files);
+
+	ThumbnailManager *manager = new ThumbnailManager;
+	ThumbnailCache *cache = ThumbnailCache::get();
+	QString current;
+	int switches = 0;
+	int maxWorkers = 0;
+
+	// acquire the thumbnails like FileView does for the visible rows
+	QObject::connect(manager, &ThumbnailManager::indexUpdated, [&]() {
+		manager->request(files[current]);
+	});
+	QObject::connect(manager, &ThumbnailManager::loadingFinished, [&]() {
+		manager->request(files[current]);
+	});
+
+	QTimer timer;
+	timer.setInterval(1000 / rate);
+
+	QObject::connect(&timer, &QTimer::timeout, [&]() {
+		if (switches == count)
+		{
+			timer.stop();
+			a.quit();
+			return;
+		}
+
+		current = dirs[switches % dirs.count()];
+
+		// every other switch lists the directory again instead of
+		// restoring the remembered listing
+		if (switches % 2)
+			manager->forget(current);
+
+		manager->setPath(current);
+		switches++;
+		maxWorkers = qMax(maxWorkers, ThumbnailWorker::count());
+	});
+
+	QElapsedTimer elapsed;
+	elapsed.start();
+	timer.start();
+	a.exec();
+
+	out << "switched " << switches << " times in " << elapsed.elapsed() << " ms, "
+		<< "at most " << maxWorkers << " workers alive" << endl;
+
+	delete manager;
+
+	// abandoned workers delete themselves once their listing is interrupted
+	elapsed.restart();
+
+	while (ThumbnailWorker::count() > 0 && elapsed.elapsed() < DRAIN_TIMEOUT_MS)
+	{
+		QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+		QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+	}
+
+	int ret = 0;
+
+	if (ThumbnailWorker::count() > 0)
+	{
+		err << "FAIL: " << ThumbnailWorker::count() << " workers not deleted" << endl;
+		ret = 1;
+	}
+
+	if (cache->acquiredCount() > 0)
+	{
+		err << "FAIL: " << cache->acquiredCount() << " thumbnails still acquired" << endl;
+		ret = 1;
+	}
+
+	if (ret == 0)
+		out << "OK" << endl;
+
+	return ret;
+}
@@ -0,0 +1,73 @@
+# -------------------------------------------------
+# Stress test of ThumbnailManager switching directories,
+# see main.cpp
+# -------------------------------------------------
+QT += widgets
+QT -= network
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = thumbnail-stress
+TEMPLATE = app
+
+ROOT = ../..
+
+INCLUDEPATH += $$ROOT/src
+INCLUDEPATH += $$ROOT/src/filefilters
+INCLUDEPATH += $$ROOT/libqdxf/libdxfrw/src
+
+unix:LIBS += -lz
+
+poppler {
+    DEFINES += HAVE_POPPLER
+    unix {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += poppler-qt5
+    }
+}
+
+SOURCES += main.cpp \
+    $$ROOT/src/thumbnailmanager.cpp \
+    $$ROOT/src/thumbnailcache.cpp \
+    $$ROOT/src/thumbnaildiskcache.cpp \
+    $$ROOT/src/thumbnailpack.cpp \
+    $$ROOT/src/imagescaler.cpp \
+    $$ROOT/src/thumbnailer.cpp \
+    $$ROOT/src/softwarerasterizer.cpp \
+    $$ROOT/src/stlthumbnailer.cpp \
+    $$ROOT/src/dxfthumbnailer.cpp \
+    $$ROOT/src/compounddocument.cpp \
+    $$ROOT/src/olethumbnailer.cpp \
+    $$ROOT/src/zipreader.cpp \
+    $$ROOT/src/officethumbnailer.cpp \
+    $$ROOT/src/blendthumbnailer.cpp \
+    $$ROOT/src/pdfthumbnailer.cpp \
+    $$ROOT/src/settings.cpp \
+    $$ROOT/src/zimautils.cpp \
+    $$ROOT/src/datasourcemodel.cpp \
+    $$ROOT/src/iconcache.cpp \
+    $$ROOT/src/file.cpp \
+    $$ROOT/src/metadata.cpp \
+    $$ROOT/src/metadata/metadatamigration.cpp \
+    $$ROOT/src/metadata/metadatamigrator.cpp \
+    $$ROOT/src/metadata/migrations/metadatav2migration.cpp \
+    $$ROOT/src/partcache.cpp \
+    $$ROOT/src/partnameindex.cpp \
+    $$ROOT/src/partversionindex.cpp \
+    $$ROOT/src/columnmatcher.cpp \
+    $$ROOT/src/filefilters/filefilter.cpp \
+    $$ROOT/src/filefilters/extensionfilter.cpp \
+    $$ROOT/src/filefilters/filtergroup.cpp \
+    $$ROOT/src/filefilters/versionfilter.cpp \
+    $$ROOT/libqdxf/libdxfrw/src/drw_entities.cpp \
+    $$ROOT/libqdxf/libdxfrw/src/drw_objects.cpp \
+    $$ROOT/libqdxf/libdxfrw/src/libdxfrw.cpp \
+    $$ROOT/libqdxf/libdxfrw/src/intern/drw_textcodec.cpp \
+    $$ROOT/libqdxf/libdxfrw/src/intern/dxfreader.cpp \
+    $$ROOT/libqdxf/libdxfrw/src/intern/dxfwriter.cpp
+
+HEADERS += $$ROOT/src/thumbnailmanager.h \
+    $$ROOT/src/thumbnailcache.h \
+    $$ROOT/src/metadata.h \
+    $$ROOT/src/partcache.h \
+    $$ROOT/src/datasourcemodel.h \
+    $$ROOT/src/iconcache.h
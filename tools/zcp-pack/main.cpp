@@ -0,0 +1,96 @@
+/*
+  ZIMA-CAD-Parts
+  http://www.zima-construction.cz/software/ZIMA-CAD-Parts
+
+  Copyright (C) 2011-2012 Jakub Skokan <aither@havefun.cz>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+#include "packer.h"
+
+// The smallest ThumbnailCache tiers
+#define DEFAULT_SIZES "32,64,128"
+
+
+/*!
+ * Pre-generates THUMBNAILS_PACK of every directory of the given data
+ * sources, so that users browsing a share load one memory mapped file
+ * per directory instead of decoding every thumbnail.
+ *
+ * Only directories whose thumbnails changed since the last run are
+ * packed again, so it is cheap to run nightly.
+ */
+int main(int argc, char *argv[])
+{
+	// no display is needed, QImage works without a GUI application
+	QCoreApplication a(argc, argv);
+	a.setOrganizationName("ZIMA-Construction");
+	a.setApplicationName("zcp-pack");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Pre-generates thumbnail packs of ZIMA-CAD-Parts data sources.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("root", "Root directory of a data source.", "<root>...");
+
+	QCommandLineOption sizesOpt(QStringList() << "s" << "sizes", "Comma separated thumbnail widths.", "sizes", DEFAULT_SIZES);
+	QCommandLineOption threadsOpt(QStringList() << "j" << "threads", "Number of worker threads.", "n", "0");
+	QCommandLineOption forceOpt(QStringList() << "f" << "force", "Rebuild packs that are up to date.");
+	QCommandLineOption verboseOpt(QStringList() << "v" << "verbose", "Print every packed directory.");
+
+	parser.addOption(sizesOpt);
+	parser.addOption(threadsOpt);
+	parser.addOption(forceOpt);
+	parser.addOption(verboseOpt);
+	parser.process(a);
+
+	QTextStream err(stderr);
+	QStringList roots = parser.positionalArguments();
+
+	if (roots.isEmpty())
+		parser.showHelp(1);
+
+	QList<int> sizes;
+
+	foreach (const QString &s, parser.value(sizesOpt).split(',', QString::SkipEmptyParts))
+	{
+		bool ok;
+		int size = s.trimmed().toInt(&ok);
+
+		if (!ok || size <= 0)
+		{
+			err << "zcp-pack: invalid size " << s << endl;
+			return 1;
+		}
+
+		if (!sizes.contains(size))
+			sizes << size;
+	}
+
+	if (sizes.isEmpty())
+	{
+		err << "zcp-pack: no sizes given" << endl;
+		return 1;
+	}
+
+	Packer packer(sizes, parser.value(threadsOpt).toInt(), parser.isSet(forceOpt), parser.isSet(verboseOpt));
+	packer.run(roots);
+	packer.printStats();
+
+	return 0;
+}
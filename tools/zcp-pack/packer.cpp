@@ -0,0 +1,205 @@
+#include "packer.h"
+#include "datasourcepaths.h"
+#include "thumbnailpack.h"
+#include "imagescaler.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QThread>
+#include <QSet>
+#include <QTextStream>
+#include <algorithm>
+
+// Thumbnails picked up by ThumbnailWorker::findThumbnails()
+#define THUMBNAIL_PATTERNS QStringList() << "*.png" << "*.jpg" << "*.jpeg"
+
+
+PackerStats::PackerStats()
+	: directories(0),
+	  packed(0),
+	  skipped(0),
+	  failed(0),
+	  images(0),
+	  bytesRead(0),
+	  bytesWritten(0)
+{
+}
+
+
+PackJob::PackJob(Packer *packer, const QString &dir)
+	: m_packer(packer),
+	  m_dir(dir)
+{
+}
+
+void PackJob::run()
+{
+	// be nice to users browsing the share at the same time
+	QThread::currentThread()->setPriority(QThread::LowPriority);
+	m_packer->packDirectory(m_dir);
+}
+
+
+Packer::Packer(const QList<int> &sizes, int threads, bool force, bool verbose)
+	: m_sizes(sizes),
+	  m_threads(threads),
+	  m_force(force),
+	  m_verbose(verbose)
+{
+	std::sort(m_sizes.begin(), m_sizes.end());
+}
+
+void Packer::run(const QStringList &roots)
+{
+	QThreadPool pool;
+
+	if (m_threads > 0)
+		pool.setMaxThreadCount(m_threads);
+
+	m_timer.start();
+
+	foreach (const QString &root, roots)
+	{
+		QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable,
+						QDirIterator::Subdirectories);
+
+		while (it.hasNext())
+		{
+			QString dir = it.next();
+
+			// skip the index directories themselves
+			if (it.fileName() == METADATA_DIR)
+				continue;
+
+			if (!QFileInfo(dir + "/" + THUMBNAILS_DIR).isDir())
+				continue;
+
+			m_stats.directories.ref();
+			pool.start(new PackJob(this, dir));
+		}
+	}
+
+	pool.waitForDone();
+}
+
+void Packer::packDirectory(const QString &dir)
+{
+	QTextStream err(stderr);
+
+	if (!m_force && isUpToDate(dir))
+	{
+		m_stats.skipped.ref();
+		return;
+	}
+
+	QDir thumbDir(dir + "/" + THUMBNAILS_DIR);
+	QList<ThumbnailPack::Item> items;
+	QSet<QString> found;
+	const int largest = m_sizes.last();
+
+	foreach (const QFileInfo &fi, thumbDir.entryInfoList(THUMBNAIL_PATTERNS, QDir::Files | QDir::Readable, QDir::Name))
+	{
+		// same precedence as ThumbnailWorker, the first base name wins
+		if (found.contains(fi.baseName()))
+			continue;
+
+		found.insert(fi.baseName());
+
+		// decode once at the largest size, smaller ones are scaled from it
+		QImageReader reader(fi.absoluteFilePath());
+		QImage img = ImageScaler::readToFit(reader, QSize(largest, largest));
+
+		if (img.isNull())
+		{
+			err << "zcp-pack: cannot read " << fi.absoluteFilePath() << ": " << reader.errorString() << endl;
+			continue;
+		}
+
+		ThumbnailPack::Item item;
+		item.baseName = fi.baseName();
+		item.fileName = fi.fileName();
+
+		foreach (int size, m_sizes)
+		{
+			if (size == largest)
+				item.images << img;
+			else
+				item.images << ImageScaler::scaledToFit(img, QSize(size, size));
+		}
+
+		items << item;
+		m_stats.images.ref();
+		m_stats.bytesRead.fetchAndAddRelaxed(fi.size());
+	}
+
+	QString packPath = dir + "/" + THUMBNAILS_PACK;
+
+	if (!ThumbnailPack::write(packPath, m_sizes, items))
+	{
+		err << "zcp-pack: cannot write " << packPath << endl;
+		m_stats.failed.ref();
+		return;
+	}
+
+	m_stats.packed.ref();
+	m_stats.bytesWritten.fetchAndAddRelaxed(QFileInfo(packPath).size());
+
+	if (m_verbose)
+		QTextStream(stdout) << "packed " << dir << " (" << items.count() << " thumbnails)" << endl;
+}
+
+bool Packer::isUpToDate(const QString &dir) const
+{
+	QFileInfo packFi(dir + "/" + THUMBNAILS_PACK);
+
+	if (!packFi.exists())
+		return false;
+
+	const QDateTime packed = packFi.lastModified();
+	QFileInfo dirFi(dir + "/" + THUMBNAILS_DIR);
+
+	// added or removed thumbnails change the directory
+	if (dirFi.lastModified() > packed)
+		return false;
+
+	// overwritten thumbnails do not
+	foreach (const QFileInfo &fi, QDir(dirFi.absoluteFilePath()).entryInfoList(THUMBNAIL_PATTERNS, QDir::Files))
+	{
+		if (fi.lastModified() > packed)
+			return false;
+	}
+
+	ThumbnailPack pack(packFi.absoluteFilePath());
+
+	if (!pack.isValid())
+		return false;
+
+	foreach (int size, m_sizes)
+	{
+		if (!pack.hasSize(size))
+			return false;
+	}
+
+	return true;
+}
+
+void Packer::printStats() const
+{
+	const double secs = qMax<qint64>(m_timer.elapsed(), 1) / 1000.0;
+	const double mb = 1024.0 * 1024.0;
+	QTextStream out(stdout);
+
+	out << "directories: " << m_stats.directories.load()
+		<< ", packed: " << m_stats.packed.load()
+		<< ", up to date: " << m_stats.skipped.load()
+		<< ", failed: " << m_stats.failed.load() << endl;
+	out << "thumbnails: " << m_stats.images.load()
+		<< ", read: " << QString::number(m_stats.bytesRead.load() / mb, 'f', 1) << " MB"
+		<< ", written: " << QString::number(m_stats.bytesWritten.load() / mb, 'f', 1) << " MB" << endl;
+	out << "elapsed: " << QString::number(secs, 'f', 1) << " s, "
+		<< QString::number(m_stats.images.load() / secs, 'f', 1) << " thumbnails/s, "
+		<< QString::number(m_stats.bytesRead.load() / mb / secs, 'f', 2) << " MB/s" << endl;
+}
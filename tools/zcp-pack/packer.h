@@ -0,0 +1,71 @@
+#ifndef PACKER_H
+#define PACKER_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QAtomicInteger>
+#include <QStringList>
+#include <QElapsedTimer>
+
+/*!
+ * \brief Totals of one Packer run
+ */
+struct PackerStats
+{
+	QAtomicInteger<int> directories;
+	QAtomicInteger<int> packed;
+	QAtomicInteger<int> skipped;
+	QAtomicInteger<int> failed;
+	QAtomicInteger<int> images;
+	QAtomicInteger<qint64> bytesRead;
+	QAtomicInteger<qint64> bytesWritten;
+
+	PackerStats();
+};
+
+/*!
+ * \brief Builds THUMBNAILS_PACK of all directories under data source roots
+ *
+ * Directories are packed in parallel on a QThreadPool with low priority
+ * threads. A pack is rebuilt only when it is missing, when it has other
+ * sizes or when it is older than the thumbnails directory or any
+ * thumbnail in it. Packs are written by QSaveFile and renamed over the
+ * old one, so the GUI reading the share never sees a partial pack.
+ */
+class Packer
+{
+public:
+	Packer(const QList<int> &sizes, int threads, bool force, bool verbose);
+
+	void run(const QStringList &roots);
+	void printStats() const;
+
+	//! Pack one directory, called from the thread pool
+	void packDirectory(const QString &dir);
+
+private:
+	QList<int> m_sizes;
+	int m_threads;
+	bool m_force;
+	bool m_verbose;
+	PackerStats m_stats;
+	QElapsedTimer m_timer;
+
+	bool isUpToDate(const QString &dir) const;
+};
+
+/*!
+ * \brief Packs one directory on the thread pool
+ */
+class PackJob : public QRunnable
+{
+public:
+	PackJob(Packer *packer, const QString &dir);
+	void run();
+
+private:
+	Packer *m_packer;
+	QString m_dir;
+};
+
+#endif // PACKER_H
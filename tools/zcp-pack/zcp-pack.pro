@@ -0,0 +1,23 @@
+# -------------------------------------------------
+# Command line tool to pre-generate thumbnail packs
+# of data sources, see main.cpp
+# -------------------------------------------------
+QT = core gui
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = zcp-pack
+TEMPLATE = app
+
+ROOT = ../..
+
+INCLUDEPATH += $$ROOT/src
+
+SOURCES += main.cpp \
+    packer.cpp \
+    $$ROOT/src/thumbnailpack.cpp \
+    $$ROOT/src/imagescaler.cpp
+
+HEADERS += packer.h \
+    $$ROOT/src/datasourcepaths.h \
+    $$ROOT/src/thumbnailpack.h \
+    $$ROOT/src/imagescaler.h
@@ -13,17 +13,22 @@ INCLUDEPATH += src/filefilters
 INCLUDEPATH += libqdxf/src
 INCLUDEPATH += libqdxf/libdxfrw/src
 
-# disabled 20140206 by Vlad's request:
-# only "supported" files should be displayed. For rest of files this dialog should be closed
-#    win32 {
-#        INCLUDEPATH += win32/poppler-0.24.5-win32/include
-#        LIBS += -L$$PWD/win32/poppler-0.24.5-win32/bin
-#        LIBS += -lpoppler-qt5
-#    }
-#    unix {
-#        CONFIG += link_pkgconfig
-#        PKGCONFIG += poppler-qt5
-#    }
+# ZipReader uses the zlib bundled with Qt on Windows
+unix:LIBS += -lz
+
+# PDF thumbnails and product view, build with "qmake CONFIG+=poppler"
+poppler {
+    DEFINES += HAVE_POPPLER
+    win32 {
+        INCLUDEPATH += win32/poppler-0.24.5-win32/include
+        LIBS += -L$$PWD/win32/poppler-0.24.5-win32/bin
+        LIBS += -lpoppler-qt5
+    }
+    unix {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += poppler-qt5
+    }
+}
 
 SOURCES += src/zima-cad-parts.cpp \
     src/mainwindow.cpp \
@@ -108,7 +113,27 @@ SOURCES += src/zima-cad-parts.cpp \
     src/maintoolbar.cpp \
     src/datasourcehistory.cpp \
     src/partselector.cpp \
-    src/partcache.cpp
+    src/partcache.cpp \
+    src/columnmatcher.cpp \
+    src/partnameindex.cpp \
+    src/iconcache.cpp \
+    src/partversionindex.cpp \
+    src/thumbnaildiskcache.cpp \
+    src/thumbnailcache.cpp \
+    src/thumbnailpack.cpp \
+    src/imagescaler.cpp \
+    src/thumbnailtooltip.cpp \
+    src/thumbnailer.cpp \
+    src/softwarerasterizer.cpp \
+    src/stlthumbnailer.cpp \
+    src/dxfthumbnailer.cpp \
+    src/compounddocument.cpp \
+    src/olethumbnailer.cpp \
+    src/zipreader.cpp \
+    src/officethumbnailer.cpp \
+    src/blendthumbnailer.cpp \
+    src/pdfthumbnailer.cpp \
+    src/filecopyengine.cpp
 
 HEADERS += src/mainwindow.h \
     src/settingsdialog.h \
@@ -176,7 +201,28 @@ HEADERS += src/mainwindow.h \
     src/maintoolbar.h \
     src/datasourcehistory.h \
     src/partselector.h \
-    src/partcache.h
+    src/partcache.h \
+    src/columnmatcher.h \
+    src/partnameindex.h \
+    src/iconcache.h \
+    src/partversionindex.h \
+    src/thumbnaildiskcache.h \
+    src/thumbnailcache.h \
+    src/thumbnailpack.h \
+    src/imagescaler.h \
+    src/thumbnailtooltip.h \
+    src/thumbnailer.h \
+    src/softwarerasterizer.h \
+    src/stlthumbnailer.h \
+    src/dxfthumbnailer.h \
+    src/compounddocument.h \
+    src/olethumbnailer.h \
+    src/zipreader.h \
+    src/officethumbnailer.h \
+    src/blendthumbnailer.h \
+    src/pdfthumbnailer.h \
+    src/filecopyengine.h \
+    src/datasourcepaths.h
 
 FORMS += mainwindow.ui \
     settingsdialog.ui \